@@ -0,0 +1,211 @@
+// Measures what the framework itself costs: registering tests, dispatching them, passing and failing assertions and
+// streaming results through the reporters. Every scenario runs in a forked child process, since registered tests
+// cannot be removed again, and reports its time back through a pipe. Run as
+//   c_test_bench [scenario substring]
+
+#include "c_test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// === Synthetic tests === //
+
+#define BENCH_ASSERTION_COUNT 1000000
+
+static volatile uint32_t bench_values[2] = {0, 1};
+
+void bench_empty_test(c_test_runner_t *__runner) {
+}
+
+void bench_passing_test(c_test_runner_t *__runner) {
+	EXPECT_EQ(bench_values[1], 1u, "value");
+	EXPECT_NE(bench_values[0], bench_values[1], "values");
+}
+
+void bench_failing_test(c_test_runner_t *__runner) {
+	EXPECT_EQ(bench_values[0], 1u, "value %u should have been 1", bench_values[0]);
+}
+
+void bench_assertions(c_test_runner_t *__runner) {
+	for (uint32_t i = 0; i < BENCH_ASSERTION_COUNT; i++) {
+		EXPECT_LT(bench_values[i & 1], 2u, "value %u at %u", bench_values[i & 1], i);
+	}
+}
+
+// Every other assertion fails, to measure the failure path.
+void bench_failing_assertions(c_test_runner_t *__runner) {
+	for (uint32_t i = 0; i < BENCH_ASSERTION_COUNT / 10; i++) {
+		EXPECT_EQ(bench_values[i & 1], 0u, "value at %u", i);
+	}
+}
+
+// === Runner discarding everything === //
+
+void null_failure(c_test_runner_t *runner, const char *expression, const char *file_name, int line_number,
+				  const char *format, ...) {
+	runner->error_count++;
+}
+
+c_test_runner_t* create_null_runner() {
+	static c_test_runner_t runner;
+	runner = (c_test_runner_t){
+		.failure = null_failure,
+		.success = NULL,
+		.passed = NULL,
+		.error = null_failure,
+
+		.begin_test = NULL,
+		.end_test = NULL,
+		.skip_test = NULL,
+
+		.begin_tests = NULL,
+		.end_tests = NULL,
+
+		.benchmark_result = NULL,
+
+		.destroy = NULL,
+
+		.error_count = 0,
+		.data = NULL,
+		.current_test = NULL,
+		.current_case = 0,
+		.current_result = NULL,
+	};
+	return &runner;
+}
+
+// === Scenarios === //
+
+typedef enum {
+	RUNNER_NULL,
+	RUNNER_DEFAULT,
+	RUNNER_JSONL,
+	RUNNER_JUNIT,
+} bench_runner_kind_t;
+
+typedef struct {
+	const char *name;
+	// Measures only registering the tests when set.
+	int registration_only;
+	uint32_t test_count;
+	// Every failure_period-th test fails, 0 for none.
+	uint32_t failure_period;
+	c_test_function_t test_function;
+	bench_runner_kind_t runner_kind;
+	uint32_t worker_count;
+	int isolate;
+	// Operations counted per test, to report a cost per operation.
+	uint32_t operations_per_test;
+	const char *operation;
+} bench_scenario_t;
+
+const bench_scenario_t kScenarios[] = {
+	{"register 1k", 1, 1000, 0, bench_empty_test, RUNNER_NULL, 1, 0, 1, "test"},
+	{"register 100k", 1, 100000, 0, bench_empty_test, RUNNER_NULL, 1, 0, 1, "test"},
+	{"dispatch 1k empty", 0, 1000, 0, bench_empty_test, RUNNER_NULL, 1, 0, 1, "test"},
+	{"dispatch 100k empty", 0, 100000, 0, bench_empty_test, RUNNER_NULL, 1, 0, 1, "test"},
+	{"dispatch 100k empty, 4 workers", 0, 100000, 0, bench_empty_test, RUNNER_NULL, 4, 0, 1, "test"},
+	{"dispatch 10k empty, isolated", 0, 10000, 0, bench_empty_test, RUNNER_NULL, 1, 1, 1, "test"},
+	{"dispatch 100k passing", 0, 100000, 0, bench_passing_test, RUNNER_NULL, 1, 0, 1, "test"},
+	{"1M passing assertions", 0, 1, 0, bench_assertions, RUNNER_NULL, 1, 0, BENCH_ASSERTION_COUNT, "assertion"},
+	{"100k failing assertions", 0, 1, 0, bench_failing_assertions, RUNNER_NULL, 1, 0, BENCH_ASSERTION_COUNT / 10,
+	 "assertion"},
+	{"default runner 100k, half failing", 0, 100000, 2, bench_passing_test, RUNNER_DEFAULT, 1, 0, 1, "test"},
+	{"jsonl runner 100k, half failing", 0, 100000, 2, bench_passing_test, RUNNER_JSONL, 1, 0, 1, "test"},
+	{"junit runner 100k, half failing", 0, 100000, 2, bench_passing_test, RUNNER_JUNIT, 1, 0, 1, "test"},
+};
+
+uint64_t bench_monotonic_ns() {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint64_t)time.tv_sec * 1000000000ULL + time.tv_nsec;
+}
+
+c_test_runner_t* bench_create_runner(bench_runner_kind_t runner_kind) {
+	switch (runner_kind) {
+	case RUNNER_DEFAULT: return c_test_create_default_runner();
+	case RUNNER_JSONL: return c_test_create_jsonl_runner("/dev/null");
+	case RUNNER_JUNIT: return c_test_create_junit_runner("/dev/null");
+	default: return create_null_runner();
+	}
+}
+
+// Runs in the child process and returns the measured nanoseconds.
+uint64_t bench_run_scenario(const bench_scenario_t *scenario) {
+	// Reporters write to stdout, which would only measure the terminal.
+	if (NULL == freopen("/dev/null", "w", stdout)) {
+		perror("freopen");
+		_exit(1);
+	}
+
+	char (*names)[16] = malloc(sizeof(*names) * scenario->test_count);
+	for (uint32_t i = 0; i < scenario->test_count; i++) {
+		snprintf(names[i], sizeof(names[i]), "test_%u", i);
+	}
+
+	const uint64_t register_start_ns = bench_monotonic_ns();
+	for (uint32_t i = 0; i < scenario->test_count; i++) {
+		const int fails = 0 != scenario->failure_period && 0 == i % scenario->failure_period;
+		c_test_add_test(fails ? bench_failing_test : scenario->test_function, "Bench", names[i], __FILE__,
+						(int)i + 1);
+	}
+	const uint64_t register_end_ns = bench_monotonic_ns();
+	if (scenario->registration_only) {
+		return register_end_ns - register_start_ns;
+	}
+
+	c_test_options_t options;
+	c_test_options_init(&options);
+	options.worker_count = scenario->worker_count;
+	options.isolate = scenario->isolate;
+	options.isolation_batch_size = 100;
+
+	const uint64_t run_start_ns = bench_monotonic_ns();
+	c_test_run_with_options(bench_create_runner(scenario->runner_kind), &options);
+	return bench_monotonic_ns() - run_start_ns;
+}
+
+int main(int argc, const char **argv) {
+	const char *selection = argc > 1 ? argv[1] : NULL;
+
+	printf("%-40s %12s %16s\n", "scenario", "total ms", "ns per operation");
+	for (uint32_t i = 0; i < sizeof(kScenarios) / sizeof(kScenarios[0]); i++) {
+		const bench_scenario_t *scenario = kScenarios + i;
+		if (NULL != selection && NULL == strstr(scenario->name, selection)) {
+			continue;
+		}
+
+		int fds[2];
+		if (0 != pipe(fds)) {
+			perror("pipe");
+			return 1;
+		}
+		fflush(stdout);
+		const pid_t pid = fork();
+		if (0 == pid) {
+			close(fds[0]);
+			const uint64_t elapsed_ns = bench_run_scenario(scenario);
+			const ssize_t written = write(fds[1], &elapsed_ns, sizeof(elapsed_ns));
+			_exit(written == sizeof(elapsed_ns) ? 0 : 1);
+		}
+		close(fds[1]);
+
+		uint64_t elapsed_ns = 0;
+		const ssize_t size = read(fds[0], &elapsed_ns, sizeof(elapsed_ns));
+		close(fds[0]);
+		int status = 0;
+		waitpid(pid, &status, 0);
+		if (size != sizeof(elapsed_ns)) {
+			printf("%-40s %12s\n", scenario->name, "failed");
+			continue;
+		}
+
+		const uint64_t operation_count = (uint64_t)scenario->test_count * scenario->operations_per_test;
+		printf("%-40s %12.3f %12.1f/%s\n", scenario->name, elapsed_ns / 1e6, (double)elapsed_ns / operation_count,
+			   scenario->operation);
+	}
+	return 0;
+}
@@ -11,8 +11,8 @@
 //       you dont have as much flexibility over requiring C+GCC.
 //
 //  Q: Why not export JSON or XML?
-//    A: I want to keep things simple here and instead expose the runner_t interface allowing users to customize their 
-//       output. However I would welcome additions here!
+//    A: Both are available through --output, or c_test_create_jsonl_runner and c_test_create_junit_runner. These are 
+//       plain runners, so the runner_t interface is still the way to customize output further.
 //
 //  Q: This is a lot of macro code. Did you generate it all by hand?
 //    A: No. I generated it with python.
@@ -27,14 +27,60 @@
 //       completes without any significant reduction in boilerplate.  
 
 #include <string.h>
-
-#ifdef C_TEST_USE_PRINTF_RUNNER
 #include <stdio.h>
 #include <stdarg.h>
+#include <stddef.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-#ifdef C_TEST_USE_PRINTF_TIMER
-#include <sys/time.h>
+#ifdef C_TEST_USE_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#ifdef C_TEST_USE_FORK
+#include <dirent.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef C_TEST_USE_CPU_TIMER
+#include <sys/resource.h>
+#endif
+
+#ifdef C_TEST_USE_PERF_COUNTERS
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef C_TEST_USE_TIMEOUT_TIMER
+#include <setjmp.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+// Older glibc releases only name the thread id field by its internal name.
+#if !defined(sigev_notify_thread_id) && defined(__GLIBC__)
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
 #endif
+
+#if defined(C_TEST_FUZZ) && defined(C_TEST_USE_FORK) && defined(__GLIBC__)
+#include <execinfo.h>
+#endif
+
+#ifdef C_TEST_TRACK_ALLOCATIONS
+#include <errno.h>
+#include <malloc.h>
+#include <unistd.h>
 #endif
 
 // === Thin Vector-like struct === //
@@ -66,6 +112,13 @@ void c_test_vector_destroy(c_test_vector_t *vector) {
 	}
 }
 
+void c_test_vector_reserve(c_test_vector_t *vector, uint32_t capacity) {
+	if (capacity > vector->capacity) {
+		vector->capacity = capacity;
+		vector->data = realloc(vector->data, vector->capacity * vector->element_size);
+	}
+}
+
 void c_test_vector_push_back(c_test_vector_t *vector, const void *value) {
 	if (vector->count >= vector->capacity) {
 		vector->capacity = 2 * vector->capacity;
@@ -76,318 +129,5625 @@ void c_test_vector_push_back(c_test_vector_t *vector, const void *value) {
 }
 
 
-// === Default runner implementation printing output to stdout === //
-
-#ifdef C_TEST_USE_PRINTF_RUNNER
-
-#define CONSOLE_COLOR_RED "\x1b[31m"
-#define CONSOLE_COLOR_GREEN "\x1b[32m"
-#define CONSOLE_COLOR_RESET "\x1b[0m"
+// === Allocation tracking === //
 
-typedef struct {
-	uint64_t test_start_ms;
-	c_test_vector_t failed_test_names;
-} print_data_t;
+// With C_TEST_TRACK_ALLOCATIONS the library defines malloc and friends itself, forwarding to glibc's implementation.
+// Executables linked against it resolve their allocations here without LD_PRELOAD, and the calling thread's counters
+// are updated while a test body runs. This replaces the allocator of the whole program, including code under test that
+// brings its own, which is why the CMake option is off by default.
 
-void print_failure(c_test_runner_t* runner, const char *expression, const char *file_name, int line_number,
-				   const char *format, ...) {
-	printf("%s(%d): error: ", file_name, line_number);
+#ifdef C_TEST_TRACK_ALLOCATIONS
 
-	va_list args;
-	va_start(args, format);
-	vfprintf(stdout, format, args);
-	va_end(args);
-	printf("\n");
+#ifndef __GLIBC__
+#error "C_TEST_TRACK_ALLOCATIONS forwards to glibc's __libc_malloc and friends and requires glibc"
+#endif
 
-	printf("%s failed\n", expression);
-	
-	runner->error_count++;
-}
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void *ptr, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void *ptr);
 
-void print_error(c_test_runner_t* runner, const char *expression, const char *file_name, int line_number, 
-				 const char *format, ...) {
-	printf("%s(%d): error: ", file_name, line_number);
+typedef struct {
+	int enabled;
 
-	va_list args;
-	va_start(args, format);
-	vfprintf(stdout, format, args);
-	va_end(args);
-	printf("\n");
+	uint64_t allocation_count;
+	uint64_t allocated_bytes;
+	int64_t live_count;
+	int64_t live_bytes;
+	int64_t peak_bytes;
+} c_test_allocation_counters_t;
 
-	printf("%s failed\n", expression);
+// Initial exec so reading the counters never allocates, which would recurse into malloc.
+static __thread c_test_allocation_counters_t c_test_allocations __attribute__((tls_model("initial-exec")));
 
-	runner->error_count++;
+void c_test_track_allocation(void *ptr) {
+	if (!c_test_allocations.enabled || NULL == ptr) {
+		return;
+	}
+	const int64_t size = malloc_usable_size(ptr);
+	c_test_allocations.allocation_count++;
+	c_test_allocations.allocated_bytes += size;
+	c_test_allocations.live_count++;
+	c_test_allocations.live_bytes += size;
+	if (c_test_allocations.live_bytes > c_test_allocations.peak_bytes) {
+		c_test_allocations.peak_bytes = c_test_allocations.live_bytes;
+	}
 }
 
-void print_success(c_test_runner_t* runner, const char *file_name, int line_number) {
+void c_test_track_release(int64_t size) {
+	c_test_allocations.live_count--;
+	c_test_allocations.live_bytes -= size;
 }
 
-void print_begin_tests(c_test_runner_t* runner, uint32_t test_count) {
-	printf(CONSOLE_COLOR_GREEN "[----------] " CONSOLE_COLOR_RESET);
-	printf("Running %d tests.\n", test_count);
-	printf("\n");
+void* malloc(size_t size) {
+	void *ptr = __libc_malloc(size);
+	c_test_track_allocation(ptr);
+	return ptr;
 }
 
-void print_end_tests(c_test_runner_t* runner, uint32_t test_count, uint32_t failed_count) {
-	printf("\n");
-	printf(CONSOLE_COLOR_GREEN "[----------] " CONSOLE_COLOR_RESET);
-	printf("Completed %d tests with %d failures\n", test_count, failed_count);
-
-	if (failed_count != 0) {
-		print_data_t *print_data = runner->data;
+void* calloc(size_t count, size_t size) {
+	void *ptr = __libc_calloc(count, size);
+	c_test_track_allocation(ptr);
+	return ptr;
+}
 
-		const char **failed_test_names = print_data->failed_test_names.data;
-		for (int i = 0; i < print_data->failed_test_names.count; i++) {
-			const char *failed_test_name = failed_test_names[i];
-			printf(CONSOLE_COLOR_RED "[  FAILED  ] " CONSOLE_COLOR_RESET);
-			printf("%s\n", failed_test_name);
+void* realloc(void *ptr, size_t size) {
+	const int64_t old_size = c_test_allocations.enabled && NULL != ptr ? (int64_t)malloc_usable_size(ptr) : 0;
+	void *new_ptr = __libc_realloc(ptr, size);
+	if (c_test_allocations.enabled && (NULL != new_ptr || 0 == size)) {
+		if (NULL != ptr) {
+			c_test_track_release(old_size);
 		}
+		c_test_track_allocation(new_ptr);
 	}
+	return new_ptr;
 }
 
-#ifdef C_TEST_USE_PRINTF_TIMER
-uint64_t get_current_ms() {
-	struct timeval tv;
-	gettimeofday(&tv, NULL);
-	return tv.tv_sec * (uint64_t)1000 + (tv.tv_usec) / 1000;
+void* memalign(size_t alignment, size_t size) {
+	void *ptr = __libc_memalign(alignment, size);
+	c_test_track_allocation(ptr);
+	return ptr;
 }
-#else
-uint64_t get_current_ms() {
-	return 0;
+
+void* aligned_alloc(size_t alignment, size_t size) {
+	return memalign(alignment, size);
 }
-#endif
 
-void print_begin_test(c_test_runner_t* runner) {
-	printf(CONSOLE_COLOR_GREEN "[ RUN      ] " CONSOLE_COLOR_RESET);
-	printf("%s.%s\n", runner->current_test->name_space, runner->current_test->test_name);
-	print_data_t *print_data = runner->data;
-	print_data->test_start_ms = get_current_ms();
+void* valloc(size_t size) {
+	return memalign(sysconf(_SC_PAGESIZE), size);
 }
 
-void print_end_test(c_test_runner_t* runner, int test_success) {
-#ifdef C_TEST_USE_PRINTF_TIMER
-	const uint64_t test_end_ms = get_current_ms();
-#endif
-	print_data_t *print_data = runner->data;
-	if (test_success) {
-		printf(CONSOLE_COLOR_GREEN "[       OK ] " CONSOLE_COLOR_RESET);
-	} else {
-		printf(CONSOLE_COLOR_RED "[  FAILED  ] " CONSOLE_COLOR_RESET);
-		// add one for dot, add one for null termination
-		int test_name_size = strlen(runner->current_test->name_space) + strlen(runner->current_test->test_name) + 2;
-		char *failed_test_name = (char*)malloc(sizeof(char) * test_name_size);
-		snprintf(failed_test_name, test_name_size, "%s.%s", runner->current_test->name_space, 
-				 runner->current_test->test_name);
-		c_test_vector_push_back(&print_data->failed_test_names, &failed_test_name);
+void* pvalloc(size_t size) {
+	const size_t page_size = sysconf(_SC_PAGESIZE);
+	if (size > SIZE_MAX - page_size) {
+		errno = ENOMEM;
+		return NULL;
 	}
-#ifdef C_TEST_USE_PRINTF_TIMER
-	uint64_t duration_ms = test_end_ms - print_data->test_start_ms;
-	printf("%s.%s (%llu ms)\n", runner->current_test->name_space, runner->current_test->test_name, duration_ms);
-#else
-	printf("%s.%s (? ms)\n", runner->current_test->name_space, runner->current_test->test_name);
-#endif
+	return memalign(page_size, 0 == size ? page_size : (size + page_size - 1) / page_size * page_size);
 }
 
-void print_destroy(c_test_runner_t *runner) {
-	print_data_t *print_data = runner->data;
+void* reallocarray(void *ptr, size_t count, size_t size) {
+	if (0 != size && count > SIZE_MAX / size) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	return realloc(ptr, count * size);
+}
 
-	if (NULL == print_data) {
-		return;
+int posix_memalign(void **result, size_t alignment, size_t size) {
+	if (0 == alignment || 0 != (alignment & (alignment - 1)) || 0 != alignment % sizeof(void*)) {
+		return EINVAL;
 	}
+	void *ptr = memalign(alignment, size);
+	if (NULL == ptr && 0 != size) {
+		return ENOMEM;
+	}
+	*result = ptr;
+	return 0;
+}
 
-	char **failed_test_names = print_data->failed_test_names.data;
-	for (int i = 0; i < print_data->failed_test_names.count; i++) {
-		free(failed_test_names[i]);
+void free(void *ptr) {
+	if (c_test_allocations.enabled && NULL != ptr) {
+		c_test_track_release(malloc_usable_size(ptr));
 	}
+	__libc_free(ptr);
 }
 
-c_test_runner_t* c_test_create_default_runner() {
-	static print_data_t print_data = {
-		.test_start_ms = 0,
-	};
-	c_test_vector_init(&print_data.failed_test_names, sizeof(char*), kDefaultVectorCapacity);
-	static c_test_runner_t runner = {
-		.failure = print_failure,
-		.success = print_success,
-		.error = print_error,
+int c_test_allocation_tracking_enabled() {
+	return 1;
+}
 
-		.begin_tests = print_begin_tests,
-		.end_tests = print_end_tests,
+uint64_t c_test_allocation_count() {
+	return c_test_allocations.allocation_count;
+}
 
-		.begin_test = print_begin_test,
-		.end_test = print_end_test,
-		
-		.destroy = print_destroy,
+uint64_t c_test_allocated_bytes() {
+	return c_test_allocations.allocated_bytes;
+}
 
-		.error_count = 0,
-		.data = &print_data,
-		.current_test = NULL,
-	};
-	return &runner;
+int c_test_suspend_allocation_tracking() {
+	const int enabled = c_test_allocations.enabled;
+	c_test_allocations.enabled = 0;
+	return enabled;
 }
 
-#else
+void c_test_resume_allocation_tracking(int enabled) {
+	c_test_allocations.enabled = enabled;
+}
 
-void silent_failure(c_test_runner_t* runner, const char *expression, const char *file_name, int line_number, 
-					const char *format, ...) {
-	runner->error_count++;
+void c_test_begin_allocation_tracking() {
+	memset(&c_test_allocations, 0, sizeof(c_test_allocations));
+	c_test_allocations.enabled = 1;
 }
 
-void silent_error(c_test_runner_t* runner, const char *expression, const char *file_name, int line_number, 
-				  const char *format, ...) {
-	runner->error_count++;
+void c_test_end_allocation_tracking(c_test_result_t *result) {
+	c_test_allocations.enabled = 0;
+	result->allocation_count = c_test_allocations.allocation_count;
+	result->allocated_bytes = c_test_allocations.allocated_bytes;
+	result->peak_allocated_bytes = c_test_allocations.peak_bytes;
+	result->unfreed_allocation_count = c_test_allocations.live_count > 0 ? c_test_allocations.live_count : 0;
+	result->unfreed_bytes = c_test_allocations.live_bytes > 0 ? c_test_allocations.live_bytes : 0;
 }
 
-void silent_success(c_test_runner_t* runner, const char *file_name, int line_number) {
+#else
+
+int c_test_allocation_tracking_enabled() {
+	return 0;
 }
 
-c_test_runner_t* c_test_create_default_runner() {
-	static c_test_runner_t runner = {
-		.failure = silent_failure,
-		.success = silent_success,
-		.error = silent_error,
+uint64_t c_test_allocation_count() {
+	return 0;
+}
 
-		.begin_test = NULL,
-		.end_test = NULL,
+uint64_t c_test_allocated_bytes() {
+	return 0;
+}
 
-		.begin_tests = NULL,
-		.end_tests = NULL,
+int c_test_suspend_allocation_tracking() {
+	return 0;
+}
 
-		.destroy = NULL,
+void c_test_resume_allocation_tracking(int enabled) {
+}
 
-		.error_count = 0,
-		.data = NULL,
-		.current_test = NULL,
-	};
-	return &runner;
+void c_test_begin_allocation_tracking() {
+}
+
+void c_test_end_allocation_tracking(c_test_result_t *result) {
+	result->allocation_count = 0;
+	result->allocated_bytes = 0;
+	result->peak_allocated_bytes = 0;
+	result->unfreed_allocation_count = 0;
+	result->unfreed_bytes = 0;
 }
+
 #endif
 
-// === Global context === //
+void c_test_allocation_tracking_missing(c_test_runner_t *runner, int is_failure, const char *expression, 
+										const char *file_name, int line_number) {
+	const char *message = "Allocations are not tracked, build the library with -DC_TEST_TRACK_ALLOCATIONS=ON";
+	if (is_failure) {
+		c_test_failure(runner, expression, file_name, line_number, "%s", message);
+	} else {
+		c_test_error(runner, expression, file_name, line_number, "%s", message);
+	}
+}
+
+
+// === Arena allocator === //
+
+// Framework bookkeeping (names, messages, results) is bump allocated from an arena and released all at once, so the
+// framework adds almost nothing to the allocation counts of the code under test. A run's plan arena also holds the
+// filter and the scratch of sharding, the results cache, fixture grouping, repetition summaries and benchmark samples.
+// Runner objects and their output buffers, per worker and per child state, the registered definitions and messages too
+// long for a stack buffer or sent from other threads still use malloc, outside the allocations tracked for a test.
+
+const size_t kDefaultArenaBlockSize = 64 * 1024;
+
+typedef struct c_test_arena_block {
+	struct c_test_arena_block *next;
+	size_t size;
+	size_t used;
+	// Aligned so every allocation handed out is suitably aligned for any type.
+	max_align_t data[];
+} c_test_arena_block_t;
 
 typedef struct {
-	int initialized;
-	c_test_vector_t test_definitions;
-} c_test_context_t;
+	c_test_arena_block_t *blocks;
+	size_t block_size;
+} c_test_arena_t;
 
-c_test_context_t* c_test_get_context() {
-	static c_test_context_t context = {.initialized = 0};
-	if (!context.initialized) {
-		c_test_vector_init(&context.test_definitions, sizeof(c_test_definition_t), kDefaultVectorCapacity);
+void c_test_arena_init(c_test_arena_t *arena, size_t block_size) {
+	arena->blocks = NULL;
+	arena->block_size = block_size;
+}
 
-		context.initialized = 1;
+void c_test_arena_destroy(c_test_arena_t *arena) {
+	c_test_arena_block_t *block = arena->blocks;
+	while (NULL != block) {
+		c_test_arena_block_t *next = block->next;
+		free(block);
+		block = next;
 	}
-	return &context;
+	arena->blocks = NULL;
 }
 
+// Releases everything but the most recent block, which is kept for reuse.
+void c_test_arena_reset(c_test_arena_t *arena) {
+	if (NULL == arena->blocks) {
+		return;
+	}
+	c_test_arena_block_t *block = arena->blocks->next;
+	while (NULL != block) {
+		c_test_arena_block_t *next = block->next;
+		free(block);
+		block = next;
+	}
+	arena->blocks->next = NULL;
+	arena->blocks->used = 0;
+}
 
-// === Adding tests === //
+void* c_test_arena_alloc(c_test_arena_t *arena, size_t size) {
+	const size_t alignment = sizeof(max_align_t);
+	size = (size + alignment - 1) & ~(alignment - 1);
 
-void c_test_add_test_fixture(c_test_fixture_t fixture, c_test_fixture_function_t function, const char *fixture_name, 
-					  const char *test_name, const char *file_name, int line_number) {
-	c_test_context_t *context = c_test_get_context();
+	c_test_arena_block_t *block = arena->blocks;
+	if (NULL == block || block->size - block->used < size) {
+		const size_t block_size = size > arena->block_size ? size : arena->block_size;
+		// Arenas can grow while a test body runs, e.g. to capture a failure, which is not the test's allocation.
+		const int tracking = c_test_suspend_allocation_tracking();
+		block = (c_test_arena_block_t*)malloc(sizeof(c_test_arena_block_t) + block_size);
+		c_test_resume_allocation_tracking(tracking);
+		block->size = block_size;
+		block->used = 0;
+		if (NULL != arena->blocks && size > arena->block_size) {
+			// Keep bump allocating from the current block after an oversized allocation.
+			block->next = arena->blocks->next;
+			arena->blocks->next = block;
+		} else {
+			block->next = arena->blocks;
+			arena->blocks = block;
+		}
+	}
 
-	c_test_definition_t test_definition = {
-		.setup = fixture.setup,
-		.teardown = fixture.teardown,
-		
-		.name_space = fixture_name,
-		.test_name = test_name,
+	void *memory = (char*)block->data + block->used;
+	block->used += size;
+	return memory;
+}
 
-		.file_name = file_name,
-		.line_number = line_number,
+void* c_test_arena_calloc(c_test_arena_t *arena, size_t count, size_t size) {
+	void *memory = c_test_arena_alloc(arena, count * size);
+	memset(memory, 0, count * size);
+	return memory;
+}
 
-		.test_function = NULL,
-		.test_fixture_function = function,
-	};
+char* c_test_arena_vprintf(c_test_arena_t *arena, const char *format, va_list args) {
+	va_list size_args;
+	va_copy(size_args, args);
+	const int text_size = vsnprintf(NULL, 0, format, size_args) + 1;
+	va_end(size_args);
 
-	c_test_vector_push_back(&context->test_definitions, &test_definition);
+	char *text = (char*)c_test_arena_alloc(arena, text_size);
+	vsnprintf(text, text_size, format, args);
+	return text;
 }
 
-void c_test_add_test(c_test_function_t function, const char *name_space, const char *test_name, const char *file_name, 
-			  int line_number) {
-	c_test_context_t *context = c_test_get_context();
+char* c_test_arena_printf(c_test_arena_t *arena, const char *format, ...) ATTRIBUTE_PRINT_FORMAT(2, 3);
 
-	c_test_definition_t test_definition = {
-		.setup = NULL,
-		.teardown = NULL,
-		
-		.name_space = name_space,
-		.test_name = test_name,
+char* c_test_arena_printf(c_test_arena_t *arena, const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	char *text = c_test_arena_vprintf(arena, format, args);
+	va_end(args);
+	return text;
+}
 
-		.file_name = file_name,
-		.line_number = line_number,
 
-		.test_function = function,
-		.test_fixture_function = NULL,
-	};
+// === Clock === //
 
-	c_test_vector_push_back(&context->test_definitions, &test_definition);
+#ifdef CLOCK_MONOTONIC
+uint64_t c_test_monotonic_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * (uint64_t)1000000000 + ts.tv_nsec;
 }
+#else
+uint64_t c_test_monotonic_ns() {
+	return 0;
+}
+#endif
 
+typedef struct {
+	uint64_t wall_ns;
+	uint64_t cpu_ns;
+	uint64_t user_cpu_ns;
+	uint64_t system_cpu_ns;
+} c_test_clock_sample_t;
 
-// === Running tests === //
+#ifdef C_TEST_USE_CPU_TIMER
+uint64_t c_test_timeval_ns(struct timeval tv) {
+	return tv.tv_sec * (uint64_t)1000000000 + tv.tv_usec * (uint64_t)1000;
+}
 
-void c_test_run_test(c_test_runner_t *runner, void *data) {
-	if (NULL != runner->current_test->test_function) {
-		runner->current_test->test_function(runner);
-	} else if (NULL != runner->current_test->test_fixture_function) {
-		runner->current_test->test_fixture_function(runner, data);
-	} else {
-		runner->failure(runner, "", __FILE__, __LINE__, "No valid test function for %s:%d", 
-						runner->current_test->file_name, runner->current_test->line_number);
-	}
+uint64_t c_test_thread_cpu_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec * (uint64_t)1000000000 + ts.tv_nsec;
 }
 
-int c_test_run(c_test_runner_t* runner) {
-	c_test_context_t *context = c_test_get_context();
+void c_test_sample_rusage(c_test_clock_sample_t *sample) {
+	struct rusage usage;
+#ifdef RUSAGE_THREAD
+	getrusage(RUSAGE_THREAD, &usage);
+#else
+	getrusage(RUSAGE_SELF, &usage);
+#endif
+	sample->user_cpu_ns = c_test_timeval_ns(usage.ru_utime);
+	sample->system_cpu_ns = c_test_timeval_ns(usage.ru_stime);
+}
 
-	const c_test_definition_t *test_definitions = (const c_test_definition_t *)context->test_definitions.data;
+// The two samples read the clocks in opposite orders so the cost of sampling stays outside the measured interval.
+void c_test_sample_start_clocks(c_test_clock_sample_t *sample) {
+	c_test_sample_rusage(sample);
+	sample->cpu_ns = c_test_thread_cpu_ns();
+	sample->wall_ns = c_test_monotonic_ns();
+}
 
-	if (NULL != runner->begin_tests) {
-		runner->begin_tests(runner, context->test_definitions.count);
-	}
+void c_test_sample_end_clocks(c_test_clock_sample_t *sample) {
+	sample->wall_ns = c_test_monotonic_ns();
+	sample->cpu_ns = c_test_thread_cpu_ns();
+	c_test_sample_rusage(sample);
+}
+#else
+void c_test_sample_start_clocks(c_test_clock_sample_t *sample) {
+	sample->cpu_ns = 0;
+	sample->user_cpu_ns = 0;
+	sample->system_cpu_ns = 0;
+	sample->wall_ns = c_test_monotonic_ns();
+}
 
-	uint32_t failed_test_count = 0;
-	for (int i = 0; i < context->test_definitions.count; i++) {
-		c_test_setup_function_t setup_function = test_definitions[i].setup;
-		c_test_teardown_function_t teardown_function = test_definitions[i].teardown;
-		void *data_ = NULL;
+void c_test_sample_end_clocks(c_test_clock_sample_t *sample) {
+	c_test_sample_start_clocks(sample);
+}
+#endif
 
-		runner->current_test = test_definitions + i;
+void c_test_result_from_samples(c_test_result_t *result, const c_test_clock_sample_t *start, 
+								const c_test_clock_sample_t *end) {
+	result->duration_ns = end->wall_ns - start->wall_ns;
+	result->cpu_ns = end->cpu_ns - start->cpu_ns;
+	result->user_cpu_ns = end->user_cpu_ns - start->user_cpu_ns;
+	result->system_cpu_ns = end->system_cpu_ns - start->system_cpu_ns;
+}
 
-		if (NULL != setup_function) {
-			data_ = setup_function();
-		}
-		
-		const uint32_t start_error_count = runner->error_count;
 
-		if (NULL != runner->begin_test) {
-			runner->begin_test(runner);
-		}
+// === Performance counters === //
 
-		c_test_run_test(runner, data_);
+// With C_TEST_USE_PERF_COUNTERS each thread running tests opens one perf_event_open group counting its own user space
+// events. Events the kernel refuses, typically every hardware event inside a container, are left out of the group, and
+// when perf_event_open is unavailable entirely page faults and context switches fall back to getrusage.
 
-		const int test_success = start_error_count == runner->error_count;
+#ifdef C_TEST_USE_PERF_COUNTERS
 
-		if (!test_success) {
-			failed_test_count++;
-		}
+typedef struct {
+	uint32_t counter;
+	uint32_t type;
+	uint64_t config;
+} c_test_counter_event_t;
 
-		if (NULL != runner->end_test) {
-			runner->end_test(runner, test_success);
-		}
-		
-		if (NULL != teardown_function) {
-			teardown_function(data_);
-		}
+#define C_TEST_COUNTER_EVENT_COUNT 6
 
-		runner->current_test = NULL;
-	}
+const c_test_counter_event_t kCounterEvents[C_TEST_COUNTER_EVENT_COUNT] = {
+	{C_TEST_COUNTER_CYCLES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+	{C_TEST_COUNTER_INSTRUCTIONS, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+	{C_TEST_COUNTER_CACHE_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+	{C_TEST_COUNTER_BRANCH_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+	{C_TEST_COUNTER_PAGE_FAULTS, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+	{C_TEST_COUNTER_CONTEXT_SWITCHES, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+};
 
-	if (NULL != runner->end_tests) {
-		runner->end_tests(runner, context->test_definitions.count, failed_test_count);
+typedef struct {
+	int initialized;
+	int fds[C_TEST_COUNTER_EVENT_COUNT];
+	// The counters of the group's events, in the order the kernel reports them.
+	uint32_t counters[C_TEST_COUNTER_EVENT_COUNT];
+	uint32_t event_count;
+} c_test_counter_group_t;
+
+static __thread c_test_counter_group_t c_test_counter_group;
+
+typedef struct {
+	c_test_counters_t counters;
+	uint64_t time_enabled_ns;
+	uint64_t time_running_ns;
+} c_test_counter_sample_t;
+
+uint64_t* c_test_counter_value(c_test_counters_t *counters, uint32_t counter) {
+	switch (counter) {
+	case C_TEST_COUNTER_CYCLES: return &counters->cycles;
+	case C_TEST_COUNTER_INSTRUCTIONS: return &counters->instructions;
+	case C_TEST_COUNTER_CACHE_MISSES: return &counters->cache_misses;
+	case C_TEST_COUNTER_BRANCH_MISSES: return &counters->branch_misses;
+	case C_TEST_COUNTER_PAGE_FAULTS: return &counters->page_faults;
+	default: return &counters->context_switches;
+	}
+}
+
+void c_test_counter_group_open(c_test_counter_group_t *group) {
+	group->initialized = 1;
+	group->event_count = 0;
+	for (uint32_t i = 0; i < C_TEST_COUNTER_EVENT_COUNT; i++) {
+		struct perf_event_attr attributes;
+		memset(&attributes, 0, sizeof(attributes));
+		attributes.size = sizeof(attributes);
+		attributes.type = kCounterEvents[i].type;
+		attributes.config = kCounterEvents[i].config;
+		attributes.exclude_kernel = PERF_TYPE_HARDWARE == kCounterEvents[i].type;
+		attributes.exclude_hv = 1;
+		attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		const int leader_fd = 0 == group->event_count ? -1 : group->fds[0];
+		const int fd = (int)syscall(SYS_perf_event_open, &attributes, 0, -1, leader_fd, 0);
+		if (fd >= 0) {
+			group->fds[group->event_count] = fd;
+			group->counters[group->event_count] = kCounterEvents[i].counter;
+			group->event_count++;
+		}
+	}
+}
+
+void c_test_counters_release() {
+	c_test_counter_group_t *group = &c_test_counter_group;
+	for (uint32_t i = 0; i < group->event_count; i++) {
+		close(group->fds[i]);
+	}
+	group->event_count = 0;
+	group->initialized = 0;
+}
+
+void c_test_sample_counters(c_test_counter_sample_t *sample) {
+	c_test_counter_group_t *group = &c_test_counter_group;
+	if (!group->initialized) {
+		c_test_counter_group_open(group);
+	}
+	memset(sample, 0, sizeof(c_test_counter_sample_t));
+
+	if (group->event_count > 0) {
+		uint64_t values[3 + C_TEST_COUNTER_EVENT_COUNT];
+		if (read(group->fds[0], values, sizeof(values)) > 0 && values[0] == group->event_count) {
+			sample->time_enabled_ns = values[1];
+			sample->time_running_ns = values[2];
+			for (uint32_t i = 0; i < group->event_count; i++) {
+				*c_test_counter_value(&sample->counters, group->counters[i]) = values[3 + i];
+				sample->counters.available |= group->counters[i];
+			}
+		}
+	}
+
+	const uint32_t usage_counters = C_TEST_COUNTER_PAGE_FAULTS | C_TEST_COUNTER_CONTEXT_SWITCHES;
+	if (0 == (sample->counters.available & usage_counters)) {
+		struct rusage usage;
+#ifdef RUSAGE_THREAD
+		getrusage(RUSAGE_THREAD, &usage);
+#else
+		getrusage(RUSAGE_SELF, &usage);
+#endif
+		sample->counters.page_faults = usage.ru_minflt + usage.ru_majflt;
+		sample->counters.context_switches = usage.ru_nvcsw + usage.ru_nivcsw;
+		sample->counters.available |= usage_counters;
+	}
+}
+
+void c_test_counters_from_samples(c_test_counters_t *counters, const c_test_counter_sample_t *start,
+								  const c_test_counter_sample_t *end) {
+	memset(counters, 0, sizeof(c_test_counters_t));
+	counters->available = start->counters.available & end->counters.available;
+
+	// The group was multiplexed with other events for part of the interval, so extrapolate to the whole of it.
+	const uint64_t enabled_ns = end->time_enabled_ns - start->time_enabled_ns;
+	const uint64_t running_ns = end->time_running_ns - start->time_running_ns;
+	const double scale = running_ns > 0 && running_ns < enabled_ns ? (double)enabled_ns / (double)running_ns : 1.0;
+
+	for (uint32_t i = 0; i < C_TEST_COUNTER_EVENT_COUNT; i++) {
+		const uint32_t counter = kCounterEvents[i].counter;
+		if (0 == (counters->available & counter)) {
+			continue;
+		}
+		const uint64_t delta = *c_test_counter_value((c_test_counters_t*)&end->counters, counter) -
+			*c_test_counter_value((c_test_counters_t*)&start->counters, counter);
+		*c_test_counter_value(counters, counter) =
+			C_TEST_COUNTER_PAGE_FAULTS == counter || C_TEST_COUNTER_CONTEXT_SWITCHES == counter || 1.0 == scale ?
+			delta : (uint64_t)(delta * scale);
+	}
+}
+
+#else
+
+typedef struct {
+	int unused;
+} c_test_counter_sample_t;
+
+void c_test_counters_release() {
+}
+
+void c_test_sample_counters(c_test_counter_sample_t *sample) {
+}
+
+void c_test_counters_from_samples(c_test_counters_t *counters, const c_test_counter_sample_t *start,
+								  const c_test_counter_sample_t *end) {
+	memset(counters, 0, sizeof(c_test_counters_t));
+}
+
+#endif
+
+
+// === Test names === //
+
+// Parameterized tests report each case as "<namespace>.<test>/<case>". Returns the "/<case>" part, formatted into
+// buffer, or an empty string for a plain test.
+const char* c_test_case_suffix(const c_test_definition_t *test_definition, uint32_t case_index, char *buffer, 
+							   size_t buffer_size) {
+	if (NULL == test_definition->test_param_function) {
+		return "";
+	}
+	snprintf(buffer, buffer_size, "/%u", case_index);
+	return buffer;
+}
+
+#define C_TEST_CASE_SUFFIX_SIZE 16
+
+
+// === Passed assertions === //
+
+// Hands the passed assertions of runner's current test to its passed callback, or else to its success callback once
+// per assertion, as runners written before passes were counted expect. Only the count is kept, so each of those calls
+// carries the location of the test.
+void c_test_report_passes(c_test_runner_t *runner, uint64_t passed_count) {
+	if (0 == passed_count) {
+		return;
+	}
+	if (NULL != runner->passed) {
+		runner->passed(runner, passed_count);
+	} else if (NULL != runner->success) {
+		const c_test_definition_t *test_definition = runner->current_test;
+		for (uint64_t i = 0; i < passed_count; i++) {
+			runner->success(runner, test_definition->file_name, test_definition->line_number);
+		}
+	}
+}
+
+
+// === Default runner implementation printing output to stdout === //
+
+#ifdef C_TEST_USE_PRINTF_RUNNER
+
+#define CONSOLE_COLOR_RED "\x1b[31m"
+#define CONSOLE_COLOR_GREEN "\x1b[32m"
+#define CONSOLE_COLOR_RESET "\x1b[0m"
+
+typedef struct print_failed_test {
+	struct print_failed_test *next;
+	const char *name;
+} print_failed_test_t;
+
+typedef struct {
+	c_test_arena_t arena;
+	print_failed_test_t *first_failed_test;
+	print_failed_test_t *last_failed_test;
+	uint32_t skipped_count;
+} print_data_t;
+
+void print_failure(c_test_runner_t* runner, const char *expression, const char *file_name, int line_number,
+				   const char *format, ...) {
+	printf("%s(%d): error: ", file_name, line_number);
+
+	va_list args;
+	va_start(args, format);
+	vfprintf(stdout, format, args);
+	va_end(args);
+	printf("\n");
+
+	printf("%s failed\n", expression);
+	
+	runner->error_count++;
+}
+
+void print_error(c_test_runner_t* runner, const char *expression, const char *file_name, int line_number, 
+				 const char *format, ...) {
+	printf("%s(%d): error: ", file_name, line_number);
+
+	va_list args;
+	va_start(args, format);
+	vfprintf(stdout, format, args);
+	va_end(args);
+	printf("\n");
+
+	printf("%s failed\n", expression);
+
+	runner->error_count++;
+}
+
+void print_success(c_test_runner_t* runner, const char *file_name, int line_number) {
+}
+
+void print_passed(c_test_runner_t* runner, uint64_t passed_count) {
+}
+
+void print_begin_tests(c_test_runner_t* runner, uint32_t test_count) {
+	printf(CONSOLE_COLOR_GREEN "[----------] " CONSOLE_COLOR_RESET);
+	printf("Running %d tests.\n", test_count);
+	printf("\n");
+}
+
+void print_end_tests(c_test_runner_t* runner, uint32_t test_count, uint32_t failed_count) {
+	printf("\n");
+	printf(CONSOLE_COLOR_GREEN "[----------] " CONSOLE_COLOR_RESET);
+	printf("Completed %d tests with %d failures", test_count, failed_count);
+	print_data_t *print_data = runner->data;
+	if (print_data->skipped_count > 0) {
+		printf(", %u skipped", print_data->skipped_count);
+	}
+	printf("\n");
+
+	if (failed_count != 0) {
+		for (print_failed_test_t *failed_test = print_data->first_failed_test; NULL != failed_test; 
+			 failed_test = failed_test->next) {
+			printf(CONSOLE_COLOR_RED "[  FAILED  ] " CONSOLE_COLOR_RESET);
+			printf("%s\n", failed_test->name);
+		}
+	}
+}
+
+void print_benchmark_result(c_test_runner_t* runner, const c_test_benchmark_result_t *result, int success) {
+	if (success) {
+		printf(CONSOLE_COLOR_GREEN "[    BENCH ] " CONSOLE_COLOR_RESET);
+	} else {
+		printf(CONSOLE_COLOR_RED "[  FAILED  ] " CONSOLE_COLOR_RESET);
+	}
+	printf("%s.%s %.2f ns/op (min %.2f, median %.2f, p99 %.2f, stddev %.2f) %u x %llu iterations\n", 
+		   runner->current_test->name_space, runner->current_test->test_name, result->mean_ns, result->min_ns, 
+		   result->median_ns, result->p99_ns, result->stddev_ns, result->repetitions, 
+		   (unsigned long long)result->iterations);
+}
+
+void print_begin_test(c_test_runner_t* runner) {
+	char suffix[C_TEST_CASE_SUFFIX_SIZE];
+	printf(CONSOLE_COLOR_GREEN "[ RUN      ] " CONSOLE_COLOR_RESET);
+	printf("%s.%s%s\n", runner->current_test->name_space, runner->current_test->test_name, 
+		   c_test_case_suffix(runner->current_test, runner->current_case, suffix, sizeof(suffix)));
+}
+
+void print_counters(const c_test_counters_t *counters) {
+	if (counters->available & C_TEST_COUNTER_CYCLES) {
+		printf(", %llu cycles", (unsigned long long)counters->cycles);
+		if ((counters->available & C_TEST_COUNTER_INSTRUCTIONS) && counters->cycles > 0) {
+			printf(", %.2f IPC", (double)counters->instructions / (double)counters->cycles);
+		}
+	}
+	if ((counters->available & C_TEST_COUNTER_CACHE_MISSES) && counters->cache_misses > 0) {
+		printf(", %llu cache misses", (unsigned long long)counters->cache_misses);
+	}
+	if ((counters->available & C_TEST_COUNTER_BRANCH_MISSES) && counters->branch_misses > 0) {
+		printf(", %llu branch misses", (unsigned long long)counters->branch_misses);
+	}
+	if ((counters->available & C_TEST_COUNTER_PAGE_FAULTS) && counters->page_faults > 0) {
+		printf(", %llu page faults", (unsigned long long)counters->page_faults);
+	}
+	if ((counters->available & C_TEST_COUNTER_CONTEXT_SWITCHES) && counters->context_switches > 0) {
+		printf(", %llu context switches", (unsigned long long)counters->context_switches);
+	}
+}
+
+void print_end_test(c_test_runner_t* runner, int test_success) {
+	print_data_t *print_data = runner->data;
+	char suffix[C_TEST_CASE_SUFFIX_SIZE];
+	const char *case_suffix = c_test_case_suffix(runner->current_test, runner->current_case, suffix, sizeof(suffix));
+	if (test_success) {
+		printf(CONSOLE_COLOR_GREEN "[       OK ] " CONSOLE_COLOR_RESET);
+	} else {
+		printf(CONSOLE_COLOR_RED "[  FAILED  ] " CONSOLE_COLOR_RESET);
+		print_failed_test_t *failed_test = 
+			(print_failed_test_t*)c_test_arena_alloc(&print_data->arena, sizeof(print_failed_test_t));
+		failed_test->next = NULL;
+		failed_test->name = c_test_arena_printf(&print_data->arena, "%s.%s%s", runner->current_test->name_space, 
+												runner->current_test->test_name, case_suffix);
+		if (NULL == print_data->last_failed_test) {
+			print_data->first_failed_test = failed_test;
+		} else {
+			print_data->last_failed_test->next = failed_test;
+		}
+		print_data->last_failed_test = failed_test;
+	}
+#ifdef C_TEST_USE_PRINTF_TIMER
+	const c_test_result_t *result = runner->current_result;
+	printf("%s.%s%s (%.3f ms, cpu %.3f ms", runner->current_test->name_space, runner->current_test->test_name, 
+		   case_suffix, result->duration_ns / 1e6, result->cpu_ns / 1e6);
+	if (result->allocation_count > 0) {
+		printf(", %llu allocations", (unsigned long long)result->allocation_count);
+	}
+	if (result->unfreed_bytes > 0) {
+		printf(", %llu bytes unfreed in %llu allocations", (unsigned long long)result->unfreed_bytes, 
+			   (unsigned long long)result->unfreed_allocation_count);
+	}
+	if (result->passed_assertion_count > 0) {
+		printf(", %llu assertions passed", (unsigned long long)result->passed_assertion_count);
+	}
+	print_counters(&result->counters);
+	printf(")\n");
+#else
+	printf("%s.%s%s (? ms)\n", runner->current_test->name_space, runner->current_test->test_name, case_suffix);
+#endif
+}
+
+void print_skip_test(c_test_runner_t* runner) {
+	print_data_t *print_data = runner->data;
+	print_data->skipped_count++;
+	char suffix[C_TEST_CASE_SUFFIX_SIZE];
+	printf(CONSOLE_COLOR_RED "[  SKIPPED ] " CONSOLE_COLOR_RESET);
+	printf("%s.%s%s\n", runner->current_test->name_space, runner->current_test->test_name, 
+		   c_test_case_suffix(runner->current_test, runner->current_case, suffix, sizeof(suffix)));
+}
+
+void print_destroy(c_test_runner_t *runner) {
+	print_data_t *print_data = runner->data;
+
+	if (NULL == print_data) {
+		return;
+	}
+
+	c_test_arena_destroy(&print_data->arena);
+	print_data->first_failed_test = NULL;
+	print_data->last_failed_test = NULL;
+}
+
+c_test_runner_t* c_test_create_default_runner() {
+	static print_data_t print_data;
+	c_test_arena_init(&print_data.arena, kDefaultArenaBlockSize);
+	print_data.first_failed_test = NULL;
+	print_data.last_failed_test = NULL;
+	print_data.skipped_count = 0;
+	static c_test_runner_t runner = {
+		.failure = print_failure,
+		.success = print_success,
+		.passed = print_passed,
+		.error = print_error,
+
+		.begin_tests = print_begin_tests,
+		.end_tests = print_end_tests,
+
+		.benchmark_result = print_benchmark_result,
+
+		.begin_test = print_begin_test,
+		.end_test = print_end_test,
+		.skip_test = print_skip_test,
+		
+		.destroy = print_destroy,
+
+		.error_count = 0,
+		.data = &print_data,
+		.current_test = NULL,
+		.current_case = 0,
+		.current_result = NULL,
+	};
+	return &runner;
+}
+
+#else
+
+void silent_failure(c_test_runner_t* runner, const char *expression, const char *file_name, int line_number, 
+					const char *format, ...) {
+	runner->error_count++;
+}
+
+void silent_error(c_test_runner_t* runner, const char *expression, const char *file_name, int line_number, 
+				  const char *format, ...) {
+	runner->error_count++;
+}
+
+void silent_success(c_test_runner_t* runner, const char *file_name, int line_number) {
+}
+
+void silent_passed(c_test_runner_t* runner, uint64_t passed_count) {
+}
+
+c_test_runner_t* c_test_create_default_runner() {
+	static c_test_runner_t runner = {
+		.failure = silent_failure,
+		.success = silent_success,
+		.passed = silent_passed,
+		.error = silent_error,
+
+		.begin_test = NULL,
+		.end_test = NULL,
+		.skip_test = NULL,
+
+		.begin_tests = NULL,
+		.end_tests = NULL,
+
+		.benchmark_result = NULL,
+
+		.destroy = NULL,
+
+		.error_count = 0,
+		.data = NULL,
+		.current_test = NULL,
+		.current_case = 0,
+		.current_result = NULL,
+	};
+	return &runner;
+}
+#endif
+
+// === Buffered file writer === //
+
+// Reporters build each record in one buffer and hand it to the file in a single write once it is complete, so the file
+// holds every finished record, and only whole records, even if the process crashes mid-run.
+
+const size_t kWriterBufferSize = 64 * 1024;
+
+typedef struct {
+	FILE *file;
+	char *buffer;
+	size_t size;
+	size_t capacity;
+} c_test_writer_t;
+
+int c_test_writer_open(c_test_writer_t *writer, const char *path) {
+	writer->file = fopen(path, "w");
+	if (NULL == writer->file) {
+		return 0;
+	}
+	// The writer does its own buffering, one fwrite per record.
+	setvbuf(writer->file, NULL, _IONBF, 0);
+	writer->capacity = kWriterBufferSize;
+	writer->buffer = (char*)malloc(writer->capacity);
+	writer->size = 0;
+	return 1;
+}
+
+void c_test_writer_flush(c_test_writer_t *writer) {
+	if (writer->size > 0) {
+		fwrite(writer->buffer, 1, writer->size, writer->file);
+		writer->size = 0;
+	}
+}
+
+void c_test_writer_close(c_test_writer_t *writer) {
+	c_test_writer_flush(writer);
+	fclose(writer->file);
+	free(writer->buffer);
+	writer->file = NULL;
+	writer->buffer = NULL;
+}
+
+void c_test_writer_reserve(c_test_writer_t *writer, size_t size) {
+	if (writer->capacity - writer->size < size) {
+		while (writer->capacity - writer->size < size) {
+			writer->capacity *= 2;
+		}
+		writer->buffer = (char*)realloc(writer->buffer, writer->capacity);
+	}
+}
+
+void c_test_writer_append(c_test_writer_t *writer, const char *data, size_t size) {
+	c_test_writer_reserve(writer, size);
+	memcpy(writer->buffer + writer->size, data, size);
+	writer->size += size;
+}
+
+void c_test_writer_puts(c_test_writer_t *writer, const char *text) {
+	c_test_writer_append(writer, text, strlen(text));
+}
+
+void c_test_writer_printf(c_test_writer_t *writer, const char *format, ...) ATTRIBUTE_PRINT_FORMAT(2, 3);
+
+void c_test_writer_printf(c_test_writer_t *writer, const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	va_list size_args;
+	va_copy(size_args, args);
+	const int text_size = vsnprintf(NULL, 0, format, size_args);
+	va_end(size_args);
+
+	c_test_writer_reserve(writer, text_size + 1);
+	vsnprintf(writer->buffer + writer->size, text_size + 1, format, args);
+	writer->size += text_size;
+	va_end(args);
+}
+
+// Marks the end of a record and writes it out, so a crash in a later test cannot lose it.
+void c_test_writer_end_record(c_test_writer_t *writer) {
+	c_test_writer_flush(writer);
+}
+
+void c_test_writer_json_string(c_test_writer_t *writer, const char *text) {
+	c_test_writer_puts(writer, "\"");
+	for (const unsigned char *c = (const unsigned char*)text; '\0' != *c; c++) {
+		if ('"' == *c || '\\' == *c) {
+			char escaped[2] = {'\\', (char)*c};
+			c_test_writer_append(writer, escaped, 2);
+		} else if ('\n' == *c) {
+			c_test_writer_puts(writer, "\\n");
+		} else if (*c < 0x20) {
+			c_test_writer_printf(writer, "\\u%04x", *c);
+		} else {
+			c_test_writer_append(writer, (const char*)c, 1);
+		}
+	}
+	c_test_writer_puts(writer, "\"");
+}
+
+void c_test_writer_xml_string(c_test_writer_t *writer, const char *text) {
+	for (const unsigned char *c = (const unsigned char*)text; '\0' != *c; c++) {
+		switch (*c) {
+		case '&': c_test_writer_puts(writer, "&amp;"); break;
+		case '<': c_test_writer_puts(writer, "&lt;"); break;
+		case '>': c_test_writer_puts(writer, "&gt;"); break;
+		case '"': c_test_writer_puts(writer, "&quot;"); break;
+		case '\'': c_test_writer_puts(writer, "&apos;"); break;
+		case '\n': c_test_writer_puts(writer, "&#10;"); break;
+		case '\t': c_test_writer_puts(writer, "&#9;"); break;
+		default:
+			// Other control characters are not allowed in XML 1.0 at all.
+			if (*c >= 0x20) {
+				c_test_writer_append(writer, (const char*)c, 1);
+			}
+		}
+	}
+}
+
+
+// === Report runners writing JSON Lines or JUnit XML === //
+
+// Both reporters stream one record per test as it completes. Messages reported while a test runs are kept in an arena
+// that is reset after every test.
+
+typedef struct report_message {
+	struct report_message *next;
+	int is_failure;
+	const char *expression;
+	const char *file_name;
+	int line_number;
+	const char *text;
+} report_message_t;
+
+typedef struct {
+	c_test_runner_t runner;
+	c_test_writer_t writer;
+	c_test_arena_t arena;
+	report_message_t *first_message;
+	report_message_t *last_message;
+} report_data_t;
+
+void report_message(c_test_runner_t *runner, int is_failure, const char *expression, const char *file_name, 
+					int line_number, const char *format, va_list args) {
+	report_data_t *report_data = runner->data;
+	report_message_t *message = (report_message_t*)c_test_arena_alloc(&report_data->arena, sizeof(report_message_t));
+	message->next = NULL;
+	message->is_failure = is_failure;
+	message->expression = expression;
+	message->file_name = file_name;
+	message->line_number = line_number;
+	message->text = c_test_arena_vprintf(&report_data->arena, format, args);
+	if (NULL == report_data->last_message) {
+		report_data->first_message = message;
+	} else {
+		report_data->last_message->next = message;
+	}
+	report_data->last_message = message;
+
+	runner->error_count++;
+}
+
+void report_failure(c_test_runner_t *runner, const char *expression, const char *file_name, int line_number, 
+					const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	report_message(runner, 1, expression, file_name, line_number, format, args);
+	va_end(args);
+}
+
+void report_error(c_test_runner_t *runner, const char *expression, const char *file_name, int line_number, 
+				  const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	report_message(runner, 0, expression, file_name, line_number, format, args);
+	va_end(args);
+}
+
+void report_success(c_test_runner_t *runner, const char *file_name, int line_number) {
+}
+
+void report_passed(c_test_runner_t *runner, uint64_t passed_count) {
+}
+
+void report_clear_messages(report_data_t *report_data) {
+	report_data->first_message = NULL;
+	report_data->last_message = NULL;
+	c_test_arena_reset(&report_data->arena);
+}
+
+void report_destroy(c_test_runner_t *runner) {
+	report_data_t *report_data = runner->data;
+	c_test_writer_close(&report_data->writer);
+	c_test_arena_destroy(&report_data->arena);
+	free(report_data);
+}
+
+void jsonl_begin_tests(c_test_runner_t *runner, uint32_t test_count) {
+	report_data_t *report_data = runner->data;
+	c_test_writer_printf(&report_data->writer, "{\"type\":\"begin\",\"test_count\":%u}\n", test_count);
+	c_test_writer_end_record(&report_data->writer);
+}
+
+void jsonl_write_counters(c_test_writer_t *writer, const c_test_counters_t *counters) {
+	if (0 == counters->available) {
+		return;
+	}
+	const char *separator = "";
+	c_test_writer_puts(writer, ",\"counters\":{");
+	const struct {
+		uint32_t counter;
+		const char *name;
+		uint64_t value;
+	} fields[] = {
+		{C_TEST_COUNTER_CYCLES, "cycles", counters->cycles},
+		{C_TEST_COUNTER_INSTRUCTIONS, "instructions", counters->instructions},
+		{C_TEST_COUNTER_CACHE_MISSES, "cache_misses", counters->cache_misses},
+		{C_TEST_COUNTER_BRANCH_MISSES, "branch_misses", counters->branch_misses},
+		{C_TEST_COUNTER_PAGE_FAULTS, "page_faults", counters->page_faults},
+		{C_TEST_COUNTER_CONTEXT_SWITCHES, "context_switches", counters->context_switches},
+	};
+	for (uint32_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+		if (counters->available & fields[i].counter) {
+			c_test_writer_printf(writer, "%s\"%s\":%llu", separator, fields[i].name, 
+								 (unsigned long long)fields[i].value);
+			separator = ",";
+		}
+	}
+	c_test_writer_puts(writer, "}");
+}
+
+void jsonl_end_test(c_test_runner_t *runner, int test_success) {
+	report_data_t *report_data = runner->data;
+	c_test_writer_t *writer = &report_data->writer;
+	const c_test_definition_t *test = runner->current_test;
+	const c_test_result_t *result = runner->current_result;
+
+	c_test_writer_puts(writer, "{\"type\":\"test\",\"name_space\":");
+	c_test_writer_json_string(writer, test->name_space);
+	c_test_writer_puts(writer, ",\"test_name\":");
+	c_test_writer_json_string(writer, test->test_name);
+	if (NULL != test->test_param_function) {
+		c_test_writer_printf(writer, ",\"case\":%u", runner->current_case);
+	}
+	c_test_writer_puts(writer, ",\"file\":");
+	c_test_writer_json_string(writer, test->file_name);
+	c_test_writer_printf(writer, ",\"line\":%d,\"success\":%s", test->line_number, test_success ? "true" : "false");
+	if (NULL != result && result->skipped) {
+		c_test_writer_puts(writer, ",\"skipped\":true");
+	}
+	if (NULL != result) {
+		c_test_writer_printf(writer, 
+							 ",\"duration_ns\":%llu,\"cpu_ns\":%llu,\"user_cpu_ns\":%llu,\"system_cpu_ns\":%llu"
+							 ",\"allocation_count\":%llu,\"allocated_bytes\":%llu,\"peak_allocated_bytes\":%llu"
+							 ",\"unfreed_bytes\":%llu", 
+							 (unsigned long long)result->duration_ns, (unsigned long long)result->cpu_ns, 
+							 (unsigned long long)result->user_cpu_ns, (unsigned long long)result->system_cpu_ns, 
+							 (unsigned long long)result->allocation_count, 
+							 (unsigned long long)result->allocated_bytes, 
+							 (unsigned long long)result->peak_allocated_bytes, 
+							 (unsigned long long)result->unfreed_bytes);
+		if (result->passed_assertion_count > 0) {
+			c_test_writer_printf(writer, ",\"passed_assertion_count\":%llu", 
+								 (unsigned long long)result->passed_assertion_count);
+		}
+		jsonl_write_counters(writer, &result->counters);
+	}
+
+	c_test_writer_puts(writer, ",\"messages\":[");
+	for (report_message_t *message = report_data->first_message; NULL != message; message = message->next) {
+		c_test_writer_printf(writer, "%s{\"kind\":\"%s\",\"file\":", message == report_data->first_message ? "" : ",", 
+							 message->is_failure ? "failure" : "error");
+		c_test_writer_json_string(writer, message->file_name);
+		c_test_writer_printf(writer, ",\"line\":%d,\"expression\":", message->line_number);
+		c_test_writer_json_string(writer, message->expression);
+		c_test_writer_puts(writer, ",\"message\":");
+		c_test_writer_json_string(writer, message->text);
+		c_test_writer_puts(writer, "}");
+	}
+	c_test_writer_puts(writer, "]}\n");
+	c_test_writer_end_record(writer);
+
+	report_clear_messages(report_data);
+}
+
+void jsonl_end_tests(c_test_runner_t *runner, uint32_t test_count, uint32_t failed_count) {
+	report_data_t *report_data = runner->data;
+	c_test_writer_printf(&report_data->writer, "{\"type\":\"end\",\"test_count\":%u,\"failed_count\":%u}\n", 
+						 test_count, failed_count);
+	c_test_writer_flush(&report_data->writer);
+}
+
+void jsonl_benchmark_result(c_test_runner_t *runner, const c_test_benchmark_result_t *result, int success) {
+	report_data_t *report_data = runner->data;
+	c_test_writer_t *writer = &report_data->writer;
+	c_test_writer_puts(writer, "{\"type\":\"benchmark\",\"name_space\":");
+	c_test_writer_json_string(writer, runner->current_test->name_space);
+	c_test_writer_puts(writer, ",\"benchmark_name\":");
+	c_test_writer_json_string(writer, runner->current_test->test_name);
+	c_test_writer_printf(writer, 
+						 ",\"success\":%s,\"iterations\":%llu,\"repetitions\":%u,\"mean_ns\":%.3f,\"min_ns\":%.3f"
+						 ",\"median_ns\":%.3f,\"p99_ns\":%.3f,\"stddev_ns\":%.3f}\n", 
+						 success ? "true" : "false", (unsigned long long)result->iterations, result->repetitions, 
+						 result->mean_ns, result->min_ns, result->median_ns, result->p99_ns, result->stddev_ns);
+	c_test_writer_flush(writer);
+	report_clear_messages(report_data);
+}
+
+void junit_begin_tests(c_test_runner_t *runner, uint32_t test_count) {
+	report_data_t *report_data = runner->data;
+	c_test_writer_printf(&report_data->writer, 
+						 "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+						 "<testsuites tests=\"%u\">\n"
+						 "  <testsuite name=\"c_test\" tests=\"%u\">\n", test_count, test_count);
+	c_test_writer_end_record(&report_data->writer);
+}
+
+void junit_end_test(c_test_runner_t *runner, int test_success) {
+	report_data_t *report_data = runner->data;
+	c_test_writer_t *writer = &report_data->writer;
+	const c_test_definition_t *test = runner->current_test;
+	const c_test_result_t *result = runner->current_result;
+
+	c_test_writer_puts(writer, "    <testcase classname=\"");
+	c_test_writer_xml_string(writer, test->name_space);
+	c_test_writer_puts(writer, "\" name=\"");
+	c_test_writer_xml_string(writer, test->test_name);
+	char suffix[C_TEST_CASE_SUFFIX_SIZE];
+	c_test_writer_puts(writer, c_test_case_suffix(test, runner->current_case, suffix, sizeof(suffix)));
+	c_test_writer_puts(writer, "\" file=\"");
+	c_test_writer_xml_string(writer, test->file_name);
+	c_test_writer_printf(writer, "\" line=\"%d\" time=\"%.9f\"", test->line_number, 
+						 NULL == result ? 0.0 : result->duration_ns / 1e9);
+	if (NULL != result && result->skipped) {
+		c_test_writer_puts(writer, ">\n      <skipped/>\n    </testcase>\n");
+	} else if (NULL == report_data->first_message) {
+		c_test_writer_puts(writer, "/>\n");
+	} else {
+		c_test_writer_puts(writer, ">\n");
+		for (report_message_t *message = report_data->first_message; NULL != message; message = message->next) {
+			c_test_writer_puts(writer, "      <failure message=\"");
+			c_test_writer_xml_string(writer, message->expression);
+			c_test_writer_puts(writer, "\">");
+			c_test_writer_xml_string(writer, message->file_name);
+			c_test_writer_printf(writer, ":%d: ", message->line_number);
+			c_test_writer_xml_string(writer, message->text);
+			c_test_writer_puts(writer, "</failure>\n");
+		}
+		c_test_writer_puts(writer, "    </testcase>\n");
+	}
+	c_test_writer_end_record(writer);
+
+	report_clear_messages(report_data);
+}
+
+void junit_end_tests(c_test_runner_t *runner, uint32_t test_count, uint32_t failed_count) {
+	report_data_t *report_data = runner->data;
+	c_test_writer_puts(&report_data->writer, "  </testsuite>\n</testsuites>\n");
+	c_test_writer_flush(&report_data->writer);
+}
+
+c_test_runner_t* c_test_create_report_runner(const char *path) {
+	report_data_t *report_data = (report_data_t*)malloc(sizeof(report_data_t));
+	if (!c_test_writer_open(&report_data->writer, path)) {
+		fprintf(stderr, "c_test: unable to write report to %s\n", path);
+		free(report_data);
+		return NULL;
+	}
+	c_test_arena_init(&report_data->arena, kDefaultArenaBlockSize);
+	report_data->first_message = NULL;
+	report_data->last_message = NULL;
+	report_data->runner = (c_test_runner_t){
+		.failure = report_failure,
+		.success = report_success,
+		.passed = report_passed,
+		.error = report_error,
+
+		.begin_test = NULL,
+		.end_test = NULL,
+		.skip_test = NULL,
+
+		.begin_tests = NULL,
+		.end_tests = NULL,
+
+		.benchmark_result = NULL,
+
+		.destroy = report_destroy,
+
+		.error_count = 0,
+		.data = report_data,
+		.current_test = NULL,
+		.current_case = 0,
+		.current_result = NULL,
+	};
+	return &report_data->runner;
+}
+
+// Skipped tests are reported as a test record with the skipped flag set.
+void report_skip_test(c_test_runner_t *runner) {
+	const c_test_result_t skipped_result = {
+		.success = 1,
+		.skipped = 1,
+	};
+	runner->current_result = &skipped_result;
+	runner->end_test(runner, 1);
+	runner->current_result = NULL;
+}
+
+c_test_runner_t* c_test_create_jsonl_runner(const char *path) {
+	c_test_runner_t *runner = c_test_create_report_runner(path);
+	if (NULL != runner) {
+		runner->begin_tests = jsonl_begin_tests;
+		runner->end_test = jsonl_end_test;
+		runner->skip_test = report_skip_test;
+		runner->end_tests = jsonl_end_tests;
+		runner->benchmark_result = jsonl_benchmark_result;
+	}
+	return runner;
+}
+
+c_test_runner_t* c_test_create_junit_runner(const char *path) {
+	c_test_runner_t *runner = c_test_create_report_runner(path);
+	if (NULL != runner) {
+		runner->begin_tests = junit_begin_tests;
+		runner->end_test = junit_end_test;
+		runner->skip_test = report_skip_test;
+		runner->end_tests = junit_end_tests;
+	}
+	return runner;
+}
+
+
+// === Tee runner forwarding to two runners === //
+
+typedef struct {
+	c_test_runner_t runner;
+	c_test_runner_t *first;
+	c_test_runner_t *second;
+} tee_data_t;
+
+void tee_message(c_test_runner_t *runner, int is_failure, const char *expression, const char *file_name, 
+				 int line_number, const char *format, va_list args) {
+	tee_data_t *tee_data = runner->data;
+	char buffer[1024];
+	va_list size_args;
+	va_copy(size_args, args);
+	const int text_size = vsnprintf(buffer, sizeof(buffer), format, size_args);
+	va_end(size_args);
+
+	char *text = buffer;
+	if (text_size >= (int)sizeof(buffer)) {
+		const int tracking = c_test_suspend_allocation_tracking();
+		text = (char*)malloc(text_size + 1);
+		c_test_resume_allocation_tracking(tracking);
+		vsnprintf(text, text_size + 1, format, args);
+	}
+
+	c_test_runner_t *runners[2] = {tee_data->first, tee_data->second};
+	for (int i = 0; i < 2; i++) {
+		runners[i]->current_test = runner->current_test;
+		runners[i]->current_case = runner->current_case;
+		if (is_failure) {
+			runners[i]->failure(runners[i], expression, file_name, line_number, "%s", text);
+		} else {
+			runners[i]->error(runners[i], expression, file_name, line_number, "%s", text);
+		}
+	}
+
+	if (text != buffer) {
+		const int tracking = c_test_suspend_allocation_tracking();
+		free(text);
+		c_test_resume_allocation_tracking(tracking);
+	}
+	runner->error_count++;
+}
+
+void tee_failure(c_test_runner_t *runner, const char *expression, const char *file_name, int line_number, 
+				 const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	tee_message(runner, 1, expression, file_name, line_number, format, args);
+	va_end(args);
+}
+
+void tee_error(c_test_runner_t *runner, const char *expression, const char *file_name, int line_number, 
+			   const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	tee_message(runner, 0, expression, file_name, line_number, format, args);
+	va_end(args);
+}
+
+// Points both runners at the test being reported before forwarding a callback.
+void tee_sync(c_test_runner_t *runner, c_test_runner_t *target) {
+	target->current_test = runner->current_test;
+	target->current_case = runner->current_case;
+	target->current_result = runner->current_result;
+}
+
+void tee_success(c_test_runner_t *runner, const char *file_name, int line_number) {
+	tee_data_t *tee_data = runner->data;
+	c_test_runner_t *runners[2] = {tee_data->first, tee_data->second};
+	for (int i = 0; i < 2; i++) {
+		if (NULL != runners[i]->success) {
+			tee_sync(runner, runners[i]);
+			runners[i]->success(runners[i], file_name, line_number);
+		}
+	}
+}
+
+void tee_passed(c_test_runner_t *runner, uint64_t passed_count) {
+	tee_data_t *tee_data = runner->data;
+	c_test_runner_t *runners[2] = {tee_data->first, tee_data->second};
+	for (int i = 0; i < 2; i++) {
+		tee_sync(runner, runners[i]);
+		c_test_report_passes(runners[i], passed_count);
+	}
+}
+
+void tee_begin_test(c_test_runner_t *runner) {
+	tee_data_t *tee_data = runner->data;
+	c_test_runner_t *runners[2] = {tee_data->first, tee_data->second};
+	for (int i = 0; i < 2; i++) {
+		tee_sync(runner, runners[i]);
+		if (NULL != runners[i]->begin_test) {
+			runners[i]->begin_test(runners[i]);
+		}
+	}
+}
+
+void tee_end_test(c_test_runner_t *runner, int test_success) {
+	tee_data_t *tee_data = runner->data;
+	c_test_runner_t *runners[2] = {tee_data->first, tee_data->second};
+	for (int i = 0; i < 2; i++) {
+		tee_sync(runner, runners[i]);
+		if (NULL != runners[i]->end_test) {
+			runners[i]->end_test(runners[i], test_success);
+		}
+	}
+}
+
+void tee_skip_test(c_test_runner_t *runner) {
+	tee_data_t *tee_data = runner->data;
+	c_test_runner_t *runners[2] = {tee_data->first, tee_data->second};
+	for (int i = 0; i < 2; i++) {
+		tee_sync(runner, runners[i]);
+		if (NULL != runners[i]->skip_test) {
+			runners[i]->skip_test(runners[i]);
+		}
+	}
+}
+
+void tee_begin_tests(c_test_runner_t *runner, uint32_t test_count) {
+	tee_data_t *tee_data = runner->data;
+	c_test_runner_t *runners[2] = {tee_data->first, tee_data->second};
+	for (int i = 0; i < 2; i++) {
+		if (NULL != runners[i]->begin_tests) {
+			runners[i]->begin_tests(runners[i], test_count);
+		}
+	}
+}
+
+void tee_end_tests(c_test_runner_t *runner, uint32_t test_count, uint32_t failed_count) {
+	tee_data_t *tee_data = runner->data;
+	c_test_runner_t *runners[2] = {tee_data->first, tee_data->second};
+	for (int i = 0; i < 2; i++) {
+		if (NULL != runners[i]->end_tests) {
+			runners[i]->end_tests(runners[i], test_count, failed_count);
+		}
+	}
+}
+
+void tee_benchmark_result(c_test_runner_t *runner, const c_test_benchmark_result_t *result, int success) {
+	tee_data_t *tee_data = runner->data;
+	c_test_runner_t *runners[2] = {tee_data->first, tee_data->second};
+	for (int i = 0; i < 2; i++) {
+		tee_sync(runner, runners[i]);
+		if (NULL != runners[i]->benchmark_result) {
+			runners[i]->benchmark_result(runners[i], result, success);
+		}
+	}
+}
+
+void tee_destroy(c_test_runner_t *runner) {
+	tee_data_t *tee_data = runner->data;
+	if (NULL != tee_data->first->destroy) {
+		tee_data->first->destroy(tee_data->first);
+	}
+	if (NULL != tee_data->second->destroy) {
+		tee_data->second->destroy(tee_data->second);
+	}
+	free(tee_data);
+}
+
+c_test_runner_t* c_test_create_tee_runner(c_test_runner_t *first, c_test_runner_t *second) {
+	tee_data_t *tee_data = (tee_data_t*)malloc(sizeof(tee_data_t));
+	tee_data->first = first;
+	tee_data->second = second;
+	tee_data->runner = (c_test_runner_t){
+		.failure = tee_failure,
+		.success = tee_success,
+		.passed = tee_passed,
+		.error = tee_error,
+
+		.begin_test = tee_begin_test,
+		.end_test = tee_end_test,
+		.skip_test = tee_skip_test,
+
+		.begin_tests = tee_begin_tests,
+		.end_tests = tee_end_tests,
+
+		.benchmark_result = tee_benchmark_result,
+
+		.destroy = tee_destroy,
+
+		.error_count = 0,
+		.data = tee_data,
+		.current_test = NULL,
+		.current_case = 0,
+		.current_result = NULL,
+	};
+	return &tee_data->runner;
+}
+
+// Creates the runner for an output option of the form "jsonl:PATH" or "xml:PATH".
+c_test_runner_t* c_test_create_output_runner(const char *output) {
+	if (0 == strncmp(output, "jsonl:", 6)) {
+		return c_test_create_jsonl_runner(output + 6);
+	}
+	if (0 == strncmp(output, "xml:", 4)) {
+		return c_test_create_junit_runner(output + 4);
+	}
+	fprintf(stderr, "c_test: unknown output format %s, expected jsonl:PATH or xml:PATH\n", output);
+	return NULL;
+}
+
+
+// === Global context === //
+
+typedef struct {
+	int initialized;
+	c_test_vector_t test_definitions;
+	c_test_vector_t benchmark_definitions;
+
+	// The last table added through c_test_add_definition_table, so running twice does not register it twice.
+	const c_test_definition_t *const *definition_table;
+} c_test_context_t;
+
+c_test_context_t* c_test_get_context() {
+	static c_test_context_t context = {.initialized = 0, .definition_table = NULL};
+	if (!context.initialized) {
+		c_test_vector_init(&context.test_definitions, sizeof(c_test_definition_t), kDefaultVectorCapacity);
+		c_test_vector_init(&context.benchmark_definitions, sizeof(c_test_definition_t), kDefaultVectorCapacity);
+
+		context.initialized = 1;
+	}
+	return &context;
+}
+
+
+// === Adding tests === //
+
+void c_test_add_test_fixture(c_test_fixture_t fixture, c_test_fixture_function_t function, const char *fixture_name, 
+							 const char *test_name, const char *file_name, int line_number) {
+	c_test_context_t *context = c_test_get_context();
+
+	// Only a fixture that outlives the run can be shared, so a copy is always set up per test.
+	c_test_definition_t test_definition = {
+		.setup = fixture.setup,
+		.teardown = fixture.teardown,
+		.fixture = NULL,
+		
+		.name_space = fixture_name,
+		.test_name = test_name,
+
+		.file_name = file_name,
+		.line_number = line_number,
+
+		.test_function = NULL,
+		.test_fixture_function = function,
+		.test_param_function = NULL,
+		.test_fuzz_function = NULL,
+		.benchmark_function = NULL,
+
+		.params = NULL,
+		.param_size = 0,
+		.param_count = 0,
+	};
+
+	c_test_vector_push_back(&context->test_definitions, &test_definition);
+}
+
+void c_test_add_fixture_test(const c_test_fixture_t *fixture, c_test_fixture_function_t function, 
+							 const char *fixture_name, const char *test_name, const char *file_name, int line_number) {
+	c_test_context_t *context = c_test_get_context();
+
+	c_test_definition_t test_definition = {
+		.setup = fixture->setup,
+		.teardown = fixture->teardown,
+		.fixture = fixture,
+		
+		.name_space = fixture_name,
+		.test_name = test_name,
+
+		.file_name = file_name,
+		.line_number = line_number,
+
+		.test_function = NULL,
+		.test_fixture_function = function,
+		.test_param_function = NULL,
+		.test_fuzz_function = NULL,
+		.benchmark_function = NULL,
+
+		.params = NULL,
+		.param_size = 0,
+		.param_count = 0,
+	};
+
+	c_test_vector_push_back(&context->test_definitions, &test_definition);
+}
+
+void c_test_add_test(c_test_function_t function, const char *name_space, const char *test_name, const char *file_name, 
+			  int line_number) {
+	c_test_context_t *context = c_test_get_context();
+
+	c_test_definition_t test_definition = {
+		.setup = NULL,
+		.teardown = NULL,
+		.fixture = NULL,
+		
+		.name_space = name_space,
+		.test_name = test_name,
+
+		.file_name = file_name,
+		.line_number = line_number,
+
+		.test_function = function,
+		.test_fixture_function = NULL,
+		.test_param_function = NULL,
+		.test_fuzz_function = NULL,
+		.benchmark_function = NULL,
+
+		.params = NULL,
+		.param_size = 0,
+		.param_count = 0,
+	};
+
+	c_test_vector_push_back(&context->test_definitions, &test_definition);
+}
+
+void c_test_add_benchmark(c_test_benchmark_function_t function, const char *name_space, const char *benchmark_name, 
+						  const char *file_name, int line_number) {
+	c_test_context_t *context = c_test_get_context();
+
+	c_test_definition_t benchmark_definition = {
+		.setup = NULL,
+		.teardown = NULL,
+		.fixture = NULL,
+		
+		.name_space = name_space,
+		.test_name = benchmark_name,
+
+		.file_name = file_name,
+		.line_number = line_number,
+
+		.test_function = NULL,
+		.test_fixture_function = NULL,
+		.test_param_function = NULL,
+		.test_fuzz_function = NULL,
+		.benchmark_function = function,
+
+		.params = NULL,
+		.param_size = 0,
+		.param_count = 0,
+	};
+
+	c_test_vector_push_back(&context->benchmark_definitions, &benchmark_definition);
+}
+
+void c_test_add_definition(const c_test_definition_t *definition) {
+	c_test_context_t *context = c_test_get_context();
+
+	c_test_definition_t test_definition = *definition;
+	// Definitions built at compile time can only point at their fixture.
+	if (NULL != test_definition.fixture) {
+		test_definition.setup = test_definition.fixture->setup;
+		test_definition.teardown = test_definition.fixture->teardown;
+	}
+
+	if (NULL != test_definition.benchmark_function) {
+		c_test_vector_push_back(&context->benchmark_definitions, &test_definition);
+	} else {
+		c_test_vector_push_back(&context->test_definitions, &test_definition);
+	}
+}
+
+// Orders definitions by file, then by line.
+int c_test_definition_order(const c_test_definition_t *lhs, const c_test_definition_t *rhs) {
+	const int order = strcmp(lhs->file_name, rhs->file_name);
+	if (0 != order) {
+		return order;
+	}
+	return (lhs->line_number > rhs->line_number) - (lhs->line_number < rhs->line_number);
+}
+
+int c_test_compare_definitions(const void *a, const void *b) {
+	const c_test_definition_t *lhs = *(const c_test_definition_t *const*)a;
+	const c_test_definition_t *rhs = *(const c_test_definition_t *const*)b;
+	const int order = c_test_definition_order(lhs, rhs);
+	// Ties keep their registration order, which is where the definitions were before sorting.
+	return 0 != order ? order : (lhs > rhs) - (lhs < rhs);
+}
+
+// Neither constructors nor the linker keep the definitions of a build in any fixed order (link time optimization
+// reorders both), so definitions are sorted by file and line before every run to make the order reproducible.
+void c_test_sort_definitions(c_test_vector_t *definitions) {
+	c_test_definition_t *data = (c_test_definition_t*)definitions->data;
+	const uint32_t count = definitions->count;
+	uint32_t sorted_count = 1;
+	while (sorted_count < count && c_test_definition_order(&data[sorted_count - 1], &data[sorted_count]) <= 0) {
+		sorted_count++;
+	}
+	if (sorted_count >= count) {
+		return;
+	}
+
+	const c_test_definition_t **order = (const c_test_definition_t**)malloc(count * sizeof(c_test_definition_t*));
+	c_test_definition_t *sorted = (c_test_definition_t*)malloc(count * sizeof(c_test_definition_t));
+	for (uint32_t i = 0; i < count; i++) {
+		order[i] = &data[i];
+	}
+	qsort(order, count, sizeof(c_test_definition_t*), c_test_compare_definitions);
+	for (uint32_t i = 0; i < count; i++) {
+		sorted[i] = *order[i];
+	}
+	memcpy(data, sorted, count * sizeof(c_test_definition_t));
+	free(sorted);
+	free(order);
+}
+
+void c_test_add_definition_table(const c_test_definition_t *const *begin, const c_test_definition_t *const *end) {
+	c_test_context_t *context = c_test_get_context();
+	if (NULL == begin || begin >= end || begin == context->definition_table) {
+		return;
+	}
+	context->definition_table = begin;
+
+	c_test_vector_reserve(&context->test_definitions, context->test_definitions.count + (end - begin));
+	for (const c_test_definition_t *const *definition = begin; definition < end; definition++) {
+		// Sections may be padded with zeros between object files.
+		if (NULL != *definition) {
+			c_test_add_definition(*definition);
+		}
+	}
+}
+
+void c_test_add_test_param(c_test_param_function_t function, const void *params, size_t param_size, 
+						   uint32_t param_count, const char *name_space, const char *test_name, const char *file_name, 
+						   int line_number) {
+	c_test_context_t *context = c_test_get_context();
+
+	c_test_definition_t test_definition = {
+		.setup = NULL,
+		.teardown = NULL,
+		.fixture = NULL,
+		
+		.name_space = name_space,
+		.test_name = test_name,
+
+		.file_name = file_name,
+		.line_number = line_number,
+
+		.test_function = NULL,
+		.test_fixture_function = NULL,
+		.test_param_function = function,
+		.test_fuzz_function = NULL,
+		.benchmark_function = NULL,
+
+		.params = params,
+		.param_size = param_size,
+		.param_count = param_count,
+	};
+
+	c_test_vector_push_back(&context->test_definitions, &test_definition);
+}
+
+void c_test_add_fuzz_test(c_test_fuzz_function_t function, const char *name_space, const char *test_name, 
+						  const char *file_name, int line_number) {
+	c_test_context_t *context = c_test_get_context();
+
+	c_test_definition_t test_definition = {
+		.setup = NULL,
+		.teardown = NULL,
+		.fixture = NULL,
+		
+		.name_space = name_space,
+		.test_name = test_name,
+
+		.file_name = file_name,
+		.line_number = line_number,
+
+		.test_function = NULL,
+		.test_fixture_function = NULL,
+		.test_param_function = NULL,
+		.test_fuzz_function = function,
+		.benchmark_function = NULL,
+
+		.params = NULL,
+		.param_size = 0,
+		.param_count = 0,
+	};
+
+	c_test_vector_push_back(&context->test_definitions, &test_definition);
+}
+
+
+// === Test plan === //
+
+// The tests selected for a run in the order they execute, with a result for each once it has run. A parameterized
+// test is registered once and only expanded here, into one entry per case.
+
+typedef struct {
+	const c_test_definition_t *definition;
+	uint32_t case_index;
+} c_test_plan_entry_t;
+
+typedef struct {
+	c_test_plan_entry_t *entries;
+	c_test_result_t *results;
+	uint32_t count;
+
+	const c_test_options_t *options;
+	// Tests still waiting to start at this time are skipped, 0 without a time budget.
+	uint64_t deadline_ns;
+	// Set once a test body was abandoned after timing out in process. What it left behind cannot be trusted, so the
+	// remaining tests are skipped.
+	int timed_out;
+
+	// Holds the plan and everything recorded while running it.
+	c_test_arena_t arena;
+} c_test_plan_t;
+
+uint32_t c_test_case_count(const c_test_definition_t *test_definition) {
+	return NULL == test_definition->test_param_function ? 1 : test_definition->param_count;
+}
+
+void c_test_plan_init(c_test_plan_t *plan, const c_test_context_t *context, const c_test_options_t *options) {
+	const c_test_definition_t *test_definitions = (const c_test_definition_t *)context->test_definitions.data;
+	const uint32_t definition_count = context->test_definitions.count;
+
+	plan->options = options;
+	plan->deadline_ns = 0;
+	plan->timed_out = 0;
+	if (0 != options->time_budget_ms) {
+		plan->deadline_ns = c_test_monotonic_ns() + options->time_budget_ms * (uint64_t)1000000;
+	}
+	c_test_arena_init(&plan->arena, kDefaultArenaBlockSize);
+	plan->count = 0;
+	for (uint32_t i = 0; i < definition_count; i++) {
+		plan->count += c_test_case_count(test_definitions + i);
+	}
+	plan->entries = (c_test_plan_entry_t*)c_test_arena_alloc(&plan->arena, 
+															   sizeof(c_test_plan_entry_t) * plan->count);
+	plan->results = (c_test_result_t*)c_test_arena_calloc(&plan->arena, plan->count, sizeof(c_test_result_t));
+	uint32_t index = 0;
+	for (uint32_t i = 0; i < definition_count; i++) {
+		const uint32_t case_count = c_test_case_count(test_definitions + i);
+		for (uint32_t case_index = 0; case_index < case_count; case_index++) {
+			plan->entries[index].definition = test_definitions + i;
+			plan->entries[index].case_index = case_index;
+			index++;
+		}
+	}
+}
+
+// Whether the tests not started yet should be skipped, after failed_test_count failures.
+int c_test_plan_should_stop(const c_test_plan_t *plan, uint32_t failed_test_count) {
+	if (0 != plan->options->max_failures && failed_test_count >= plan->options->max_failures) {
+		return 1;
+	}
+	if (__atomic_load_n(&plan->timed_out, __ATOMIC_RELAXED)) {
+		return 1;
+	}
+	return 0 != plan->deadline_ns && c_test_monotonic_ns() >= plan->deadline_ns;
+}
+
+void c_test_plan_destroy(c_test_plan_t *plan) {
+	c_test_arena_destroy(&plan->arena);
+	plan->entries = NULL;
+	plan->results = NULL;
+	plan->count = 0;
+}
+
+typedef struct {
+	uint32_t group;
+	uint32_t index;
+	c_test_plan_entry_t entry;
+} c_test_grouped_entry_t;
+
+int c_test_compare_grouped_entries(const void *a, const void *b) {
+	const c_test_grouped_entry_t *lhs = a;
+	const c_test_grouped_entry_t *rhs = b;
+	if (lhs->group != rhs->group) {
+		return lhs->group < rhs->group ? -1 : 1;
+	}
+	return (lhs->index > rhs->index) - (lhs->index < rhs->index);
+}
+
+int c_test_is_shared_fixture(const c_test_fixture_t *fixture) {
+	return NULL != fixture && NULL != fixture->setup_suite;
+}
+
+typedef struct {
+	const c_test_fixture_t *fixture;
+	uint32_t group;
+} c_test_fixture_group_t;
+
+// Moves every test of a shared fixture up behind the fixture's first test, so each shared fixture is set up once.
+// Everything else keeps its relative order.
+void c_test_plan_group_fixtures(c_test_plan_t *plan) {
+	c_test_vector_t fixture_groups;
+	c_test_vector_init(&fixture_groups, sizeof(c_test_fixture_group_t), kDefaultVectorCapacity);
+
+	c_test_grouped_entry_t *grouped_entries = 
+		(c_test_grouped_entry_t*)c_test_arena_alloc(&plan->arena, sizeof(c_test_grouped_entry_t) * (plan->count + 1));
+	int needs_grouping = 0;
+	for (uint32_t i = 0; i < plan->count; i++) {
+		const c_test_fixture_t *fixture = plan->entries[i].definition->fixture;
+		grouped_entries[i].group = i;
+		grouped_entries[i].index = i;
+		grouped_entries[i].entry = plan->entries[i];
+		if (!c_test_is_shared_fixture(fixture)) {
+			continue;
+		}
+
+		// There are few enough shared fixtures for a linear search.
+		const c_test_fixture_group_t *groups = (const c_test_fixture_group_t*)fixture_groups.data;
+		uint32_t j = 0;
+		while (j < fixture_groups.count && groups[j].fixture != fixture) {
+			j++;
+		}
+		if (j == fixture_groups.count) {
+			c_test_fixture_group_t group = {
+				.fixture = fixture,
+				.group = i,
+			};
+			c_test_vector_push_back(&fixture_groups, &group);
+		} else {
+			grouped_entries[i].group = groups[j].group;
+			needs_grouping = 1;
+		}
+	}
+
+	if (needs_grouping) {
+		qsort(grouped_entries, plan->count, sizeof(c_test_grouped_entry_t), c_test_compare_grouped_entries);
+		for (uint32_t i = 0; i < plan->count; i++) {
+			plan->entries[i] = grouped_entries[i].entry;
+		}
+	}
+
+	c_test_vector_destroy(&fixture_groups);
+}
+
+// FNV-1a, used to key tests by "<namespace>.<test>" without formatting the name.
+const uint64_t kHashSeed = 14695981039346656037ULL;
+
+uint64_t c_test_hash_string(uint64_t hash, const char *value) {
+	for (const unsigned char *c = (const unsigned char*)value; *c != '\0'; c++) {
+		hash = (hash ^ *c) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+uint64_t c_test_hash_test_name(const c_test_plan_entry_t *entry) {
+	uint64_t hash = c_test_hash_string(kHashSeed, entry->definition->name_space);
+	hash = c_test_hash_string(hash, ".");
+	hash = c_test_hash_string(hash, entry->definition->test_name);
+	char suffix[C_TEST_CASE_SUFFIX_SIZE];
+	return c_test_hash_string(hash, c_test_case_suffix(entry->definition, entry->case_index, suffix, sizeof(suffix)));
+}
+
+
+// === Filtering === //
+
+// Filters follow the "positive:patterns-negative:patterns" form, where each pattern is a glob over
+// "<namespace>.<test>" supporting '*' and '?'. A test runs when it matches any positive pattern (or there are none)
+// and no negative pattern. Patterns are compiled once and matched against the namespace and test name in place, so
+// selecting from a large suite never formats a test name.
+
+typedef struct {
+	const char *text;
+	uint32_t size;
+	int has_wildcard;
+} c_test_pattern_t;
+
+typedef struct {
+	char *storage;
+	c_test_vector_t positive_patterns;
+	c_test_vector_t negative_patterns;
+} c_test_filter_t;
+
+void c_test_filter_add_patterns(c_test_vector_t *patterns, char *text) {
+	while (NULL != text) {
+		char *separator = strchr(text, ':');
+		if (NULL != separator) {
+			*separator = '\0';
+		}
+
+		if ('\0' != *text) {
+			c_test_pattern_t pattern = {
+				.text = text,
+				.size = strlen(text),
+				.has_wildcard = NULL != strpbrk(text, "*?"),
+			};
+			c_test_vector_push_back(patterns, &pattern);
+		}
+
+		text = NULL == separator ? NULL : separator + 1;
+	}
+}
+
+// The patterns point into a copy of text allocated from arena.
+void c_test_filter_init(c_test_filter_t *filter, const char *text, c_test_arena_t *arena) {
+	c_test_vector_init(&filter->positive_patterns, sizeof(c_test_pattern_t), kDefaultVectorCapacity);
+	c_test_vector_init(&filter->negative_patterns, sizeof(c_test_pattern_t), kDefaultVectorCapacity);
+	filter->storage = NULL;
+	if (NULL == text) {
+		return;
+	}
+
+	filter->storage = c_test_arena_printf(arena, "%s", text);
+	char *negative = strchr(filter->storage, '-');
+	if (NULL != negative) {
+		*negative = '\0';
+		c_test_filter_add_patterns(&filter->negative_patterns, negative + 1);
+	}
+	c_test_filter_add_patterns(&filter->positive_patterns, filter->storage);
+}
+
+void c_test_filter_destroy(c_test_filter_t *filter) {
+	c_test_vector_destroy(&filter->positive_patterns);
+	c_test_vector_destroy(&filter->negative_patterns);
+	filter->storage = NULL;
+}
+
+// Reads the character at index of "<namespace>.<test>[/<case>]" without building the string.
+typedef struct {
+	const char *name_space;
+	const char *test_name;
+	const char *suffix;
+	uint32_t name_space_size;
+	uint32_t test_name_size;
+	uint32_t size;
+} c_test_name_t;
+
+char c_test_name_at(const c_test_name_t *name, uint32_t index) {
+	if (index < name->name_space_size) {
+		return name->name_space[index];
+	}
+	if (index == name->name_space_size) {
+		return '.';
+	}
+	index -= name->name_space_size + 1;
+	if (index < name->test_name_size) {
+		return name->test_name[index];
+	}
+	return name->suffix[index - name->test_name_size];
+}
+
+int c_test_pattern_matches(const c_test_pattern_t *pattern, const c_test_name_t *name) {
+	if (!pattern->has_wildcard) {
+		const char *test_name = pattern->text + name->name_space_size + 1;
+		return pattern->size == name->size && 
+			0 == strncmp(pattern->text, name->name_space, name->name_space_size) && 
+			'.' == pattern->text[name->name_space_size] && 
+			0 == strncmp(test_name, name->test_name, name->test_name_size) && 
+			0 == strcmp(test_name + name->test_name_size, name->suffix);
+	}
+
+	// Greedy glob matching that backtracks to the last '*' on a mismatch.
+	uint32_t p = 0;
+	uint32_t n = 0;
+	uint32_t star = UINT32_MAX;
+	uint32_t star_match = 0;
+	while (n < name->size) {
+		if (p < pattern->size && ('?' == pattern->text[p] || pattern->text[p] == c_test_name_at(name, n))) {
+			p++;
+			n++;
+		} else if (p < pattern->size && '*' == pattern->text[p]) {
+			star = p++;
+			star_match = n;
+		} else if (UINT32_MAX != star) {
+			p = star + 1;
+			n = ++star_match;
+		} else {
+			return 0;
+		}
+	}
+	while (p < pattern->size && '*' == pattern->text[p]) {
+		p++;
+	}
+	return p == pattern->size;
+}
+
+int c_test_patterns_match(const c_test_vector_t *patterns, const c_test_name_t *name) {
+	const c_test_pattern_t *pattern = (const c_test_pattern_t*)patterns->data;
+	for (uint32_t i = 0; i < patterns->count; i++) {
+		if (c_test_pattern_matches(pattern + i, name)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int c_test_filter_matches(const c_test_filter_t *filter, const c_test_definition_t *test_definition, 
+						  uint32_t case_index) {
+	if (0 == filter->positive_patterns.count && 0 == filter->negative_patterns.count) {
+		return 1;
+	}
+
+	char suffix_buffer[C_TEST_CASE_SUFFIX_SIZE];
+	const char *suffix = c_test_case_suffix(test_definition, case_index, suffix_buffer, sizeof(suffix_buffer));
+	const uint32_t name_space_size = strlen(test_definition->name_space);
+	const uint32_t test_name_size = strlen(test_definition->test_name);
+	const c_test_name_t name = {
+		.name_space = test_definition->name_space,
+		.test_name = test_definition->test_name,
+		.suffix = suffix,
+		.name_space_size = name_space_size,
+		.test_name_size = test_name_size,
+		.size = name_space_size + 1 + test_name_size + strlen(suffix),
+	};
+
+	if (filter->positive_patterns.count > 0 && !c_test_patterns_match(&filter->positive_patterns, &name)) {
+		return 0;
+	}
+	return !c_test_patterns_match(&filter->negative_patterns, &name);
+}
+
+void c_test_plan_filter(c_test_plan_t *plan, const c_test_filter_t *filter) {
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < plan->count; i++) {
+		if (c_test_filter_matches(filter, plan->entries[i].definition, plan->entries[i].case_index)) {
+			plan->entries[count++] = plan->entries[i];
+		}
+	}
+	plan->count = count;
+}
+
+
+// === Replacing files === //
+
+// Files read back by later runs, or shared by concurrent shards and fuzzers, are written next to their path and renamed
+// over it once complete, so a reader never sees a partly written file.
+
+// Opens "<path>.tmp.<pid>" for c_test_replace_file to move over path, NULL if it cannot be created.
+FILE* c_test_open_temporary(const char *path, const char *mode, char *temporary_path, size_t temporary_path_size) {
+	snprintf(temporary_path, temporary_path_size, "%s.tmp.%ld", path, (long)getpid());
+	return fopen(temporary_path, mode);
+}
+
+// Closes file and renames it over path, returns 0 and removes it if it could not be completely written.
+int c_test_replace_file(FILE *file, const char *temporary_path, const char *path) {
+	const int written = !ferror(file);
+	if (0 != fclose(file) || !written || 0 != rename(temporary_path, path)) {
+		remove(temporary_path);
+		return 0;
+	}
+	return 1;
+}
+
+
+// === Test timings === //
+
+// Timing files hold one "<namespace>.<test> <duration_ns>" line per test.
+
+typedef struct {
+	uint64_t name_hash;
+	uint64_t duration_ns;
+} c_test_timing_t;
+
+int c_test_compare_timings(const void *a, const void *b) {
+	const uint64_t lhs = ((const c_test_timing_t*)a)->name_hash;
+	const uint64_t rhs = ((const c_test_timing_t*)b)->name_hash;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+// Loads timings sorted by name hash, returns 0 when the file cannot be read.
+int c_test_read_timings(const char *path, c_test_vector_t *timings) {
+	FILE *file = fopen(path, "r");
+	if (NULL == file) {
+		return 0;
+	}
+
+	c_test_vector_init(timings, sizeof(c_test_timing_t), kDefaultVectorCapacity);
+	char line[1024];
+	while (NULL != fgets(line, sizeof(line), file)) {
+		char *separator = strrchr(line, ' ');
+		if (NULL == separator) {
+			continue;
+		}
+		*separator = '\0';
+		c_test_timing_t timing = {
+			.name_hash = c_test_hash_string(kHashSeed, line),
+			.duration_ns = strtoull(separator + 1, NULL, 10),
+		};
+		c_test_vector_push_back(timings, &timing);
+	}
+	fclose(file);
+
+	qsort(timings->data, timings->count, sizeof(c_test_timing_t), c_test_compare_timings);
+	return 1;
+}
+
+const c_test_timing_t* c_test_find_timing(const c_test_vector_t *timings, const c_test_plan_entry_t *entry) {
+	const c_test_timing_t key = {
+		.name_hash = c_test_hash_test_name(entry),
+	};
+	return bsearch(&key, timings->data, timings->count, sizeof(c_test_timing_t), c_test_compare_timings);
+}
+
+void c_test_write_timings(const char *path, const c_test_plan_t *plan) {
+	char temporary_path[4096];
+	FILE *file = c_test_open_temporary(path, "w", temporary_path, sizeof(temporary_path));
+	if (NULL == file) {
+		fprintf(stderr, "c_test: unable to write timings to %s\n", path);
+		return;
+	}
+	for (uint32_t i = 0; i < plan->count; i++) {
+		if (plan->results[i].skipped) {
+			continue;
+		}
+		const c_test_definition_t *test_definition = plan->entries[i].definition;
+		char suffix[C_TEST_CASE_SUFFIX_SIZE];
+		fprintf(file, "%s.%s%s %llu\n", test_definition->name_space, test_definition->test_name, 
+				c_test_case_suffix(test_definition, plan->entries[i].case_index, suffix, sizeof(suffix)), 
+				(unsigned long long)plan->results[i].duration_ns);
+	}
+	if (!c_test_replace_file(file, temporary_path, path)) {
+		fprintf(stderr, "c_test: unable to write timings to %s\n", path);
+	}
+}
+
+
+// === Results cache === //
+
+// The results cache is a binary file of fixed size records sorted by key, one per test that ever ran. A record keeps
+// whether the test failed on its last run and a stamp of its source file (modification time and size) from the last
+// time it passed, so a re-run can start with, or be limited to, the tests most likely to fail.
+
+const char kResultsCacheMagic[8] = {'c', '_', 't', 'e', 's', 't', 'R', '1'};
+const char *kDefaultResultsCachePath = ".c_test_results";
+
+typedef struct {
+	uint64_t key;
+	uint64_t passed_source_stamp;
+	uint32_t failed;
+	uint32_t reserved;
+} c_test_cache_record_t;
+
+typedef struct {
+	char magic[8];
+	uint64_t count;
+} c_test_cache_header_t;
+
+int c_test_compare_cache_records(const void *a, const void *b) {
+	const uint64_t lhs = ((const c_test_cache_record_t*)a)->key;
+	const uint64_t rhs = ((const c_test_cache_record_t*)b)->key;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+uint64_t c_test_cache_key(const c_test_plan_entry_t *entry) {
+	uint64_t hash = c_test_hash_string(c_test_hash_test_name(entry), "@");
+	return c_test_hash_string(hash, entry->definition->file_name);
+}
+
+// Identifies the current contents of a source file, 0 when it cannot be found.
+uint64_t c_test_source_stamp(const char *file_name) {
+	struct stat file_stat;
+	if (0 != stat(file_name, &file_stat)) {
+		return 0;
+	}
+	const uint64_t modified_ns = (uint64_t)file_stat.st_mtim.tv_sec * 1000000000ULL + file_stat.st_mtim.tv_nsec;
+	return (modified_ns ^ (uint64_t)file_stat.st_size * 1099511628211ULL) | 1;
+}
+
+// Tests of one file are mostly consecutive in the plan, so remembering the last file avoids most stat calls.
+typedef struct {
+	const char *file_name;
+	uint64_t stamp;
+} c_test_stamp_cache_t;
+
+uint64_t c_test_cached_source_stamp(c_test_stamp_cache_t *stamps, const char *file_name) {
+	if (stamps->file_name != file_name) {
+		stamps->file_name = file_name;
+		stamps->stamp = c_test_source_stamp(file_name);
+	}
+	return stamps->stamp;
+}
+
+// Loads the records sorted by key, returns 0 when the file is missing or not a results cache.
+int c_test_read_results_cache(const char *path, c_test_vector_t *records) {
+	FILE *file = fopen(path, "rb");
+	if (NULL == file) {
+		return 0;
+	}
+
+	c_test_cache_header_t header;
+	if (1 != fread(&header, sizeof(header), 1, file) || 0 != memcmp(header.magic, kResultsCacheMagic, 8) || 
+		header.count > UINT32_MAX) {
+		fclose(file);
+		return 0;
+	}
+
+	c_test_vector_init(records, sizeof(c_test_cache_record_t), header.count + 1);
+	records->count = fread(records->data, sizeof(c_test_cache_record_t), header.count, file);
+	fclose(file);
+	return 1;
+}
+
+const c_test_cache_record_t* c_test_find_cache_record(const c_test_vector_t *records, uint64_t key) {
+	const c_test_cache_record_t record = {
+		.key = key,
+	};
+	return bsearch(&record, records->data, records->count, sizeof(c_test_cache_record_t), 
+				   c_test_compare_cache_records);
+}
+
+typedef struct {
+	uint32_t priority;
+	uint32_t index;
+	c_test_plan_entry_t entry;
+} c_test_ranked_entry_t;
+
+int c_test_compare_ranked_entries(const void *a, const void *b) {
+	const c_test_ranked_entry_t *lhs = a;
+	const c_test_ranked_entry_t *rhs = b;
+	if (lhs->priority != rhs->priority) {
+		return lhs->priority < rhs->priority ? -1 : 1;
+	}
+	return (lhs->index > rhs->index) - (lhs->index < rhs->index);
+}
+
+// Restricts the plan to the tests selected by only_failed or only_changed, then moves the tests that failed last time
+// to the front when failed_first is set. Without a readable cache every test is treated as new and changed.
+void c_test_plan_apply_results_cache(c_test_plan_t *plan, const char *path) {
+	const c_test_options_t *options = plan->options;
+	if (!options->failed_first && !options->only_failed && !options->only_changed) {
+		return;
+	}
+
+	c_test_vector_t records;
+	if (!c_test_read_results_cache(path, &records)) {
+		c_test_vector_init(&records, sizeof(c_test_cache_record_t), 1);
+	}
+
+	c_test_ranked_entry_t *ranked_entries = 
+		(c_test_ranked_entry_t*)c_test_arena_alloc(&plan->arena, sizeof(c_test_ranked_entry_t) * (plan->count + 1));
+	c_test_stamp_cache_t stamps = {
+		.file_name = NULL,
+		.stamp = 0,
+	};
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < plan->count; i++) {
+		const c_test_cache_record_t *record = c_test_find_cache_record(&records, c_test_cache_key(plan->entries + i));
+		const int failed = NULL != record && record->failed;
+		if (options->only_failed && !failed) {
+			continue;
+		}
+		if (options->only_changed && !failed && NULL != record) {
+			const uint64_t stamp = c_test_cached_source_stamp(&stamps, plan->entries[i].definition->file_name);
+			if (0 != stamp && stamp == record->passed_source_stamp) {
+				continue;
+			}
+		}
+
+		ranked_entries[count].priority = options->failed_first && !failed;
+		ranked_entries[count].index = i;
+		ranked_entries[count].entry = plan->entries[i];
+		count++;
+	}
+
+	if (options->failed_first) {
+		qsort(ranked_entries, count, sizeof(c_test_ranked_entry_t), c_test_compare_ranked_entries);
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		plan->entries[i] = ranked_entries[i].entry;
+	}
+	plan->count = count;
+
+	c_test_vector_destroy(&records);
+}
+
+// Records the outcome of every test in the plan, keeping the records of tests that did not run this time.
+void c_test_write_results_cache(const char *path, const c_test_plan_t *plan) {
+	c_test_vector_t previous_records;
+	if (!c_test_read_results_cache(path, &previous_records)) {
+		c_test_vector_init(&previous_records, sizeof(c_test_cache_record_t), 1);
+	}
+
+	c_test_vector_t records;
+	c_test_vector_init(&records, sizeof(c_test_cache_record_t), plan->count + previous_records.count + 1);
+	c_test_stamp_cache_t stamps = {
+		.file_name = NULL,
+		.stamp = 0,
+	};
+	for (uint32_t i = 0; i < plan->count; i++) {
+		if (plan->results[i].skipped) {
+			continue;
+		}
+		c_test_cache_record_t record = {
+			.key = c_test_cache_key(plan->entries + i),
+			.passed_source_stamp = 0,
+			.failed = !plan->results[i].success,
+			.reserved = 0,
+		};
+		if (plan->results[i].success) {
+			record.passed_source_stamp = c_test_cached_source_stamp(&stamps, plan->entries[i].definition->file_name);
+		} else {
+			const c_test_cache_record_t *previous = c_test_find_cache_record(&previous_records, record.key);
+			record.passed_source_stamp = NULL == previous ? 0 : previous->passed_source_stamp;
+		}
+		c_test_vector_push_back(&records, &record);
+	}
+	qsort(records.data, records.count, sizeof(c_test_cache_record_t), c_test_compare_cache_records);
+
+	// A repeated test is recorded as failed when any of its repetitions failed.
+	c_test_cache_record_t *current = (c_test_cache_record_t*)records.data;
+	uint32_t current_count = 0;
+	for (uint32_t i = 0; i < records.count; i++) {
+		if (current_count > 0 && current[current_count - 1].key == current[i].key) {
+			if (current[i].failed) {
+				current[current_count - 1] = current[i];
+			}
+		} else {
+			current[current_count++] = current[i];
+		}
+	}
+	records.count = current_count;
+
+	const c_test_cache_record_t *previous = (const c_test_cache_record_t*)previous_records.data;
+	for (uint32_t i = 0; i < previous_records.count; i++) {
+		if (NULL == bsearch(previous + i, records.data, current_count, sizeof(c_test_cache_record_t), 
+							c_test_compare_cache_records)) {
+			c_test_vector_push_back(&records, previous + i);
+		}
+	}
+	qsort(records.data, records.count, sizeof(c_test_cache_record_t), c_test_compare_cache_records);
+
+	char temporary_path[4096];
+	FILE *file = c_test_open_temporary(path, "wb", temporary_path, sizeof(temporary_path));
+	int written = 0;
+	if (NULL != file) {
+		c_test_cache_header_t header = {
+			.count = records.count,
+		};
+		memcpy(header.magic, kResultsCacheMagic, sizeof(header.magic));
+		fwrite(&header, sizeof(header), 1, file);
+		fwrite(records.data, sizeof(c_test_cache_record_t), records.count, file);
+		written = c_test_replace_file(file, temporary_path, path);
+	}
+	if (!written) {
+		fprintf(stderr, "c_test: unable to write results cache to %s\n", path);
+	}
+
+	c_test_vector_destroy(&records);
+	c_test_vector_destroy(&previous_records);
+}
+
+
+// === Sharding === //
+
+typedef struct {
+	uint32_t index;
+	uint64_t weight;
+} c_test_shard_item_t;
+
+int c_test_compare_shard_items(const void *a, const void *b) {
+	const c_test_shard_item_t *lhs = a;
+	const c_test_shard_item_t *rhs = b;
+	if (lhs->weight != rhs->weight) {
+		return lhs->weight < rhs->weight ? 1 : -1;
+	}
+	return (lhs->index > rhs->index) - (lhs->index < rhs->index);
+}
+
+// Assigns every test to a shard by placing the longest remaining test on the least loaded shard. Every shard computes
+// the same assignment from the same timings, so together they still run each test exactly once.
+void c_test_assign_weighted_shards(c_test_plan_t *plan, const c_test_vector_t *timings, uint32_t total_shards, 
+								   uint32_t *shards) {
+	c_test_shard_item_t *items = 
+		(c_test_shard_item_t*)c_test_arena_alloc(&plan->arena, sizeof(c_test_shard_item_t) * (plan->count + 1));
+	uint64_t known_duration_ns = 0;
+	uint32_t known_count = 0;
+	for (uint32_t i = 0; i < plan->count; i++) {
+		const c_test_timing_t *timing = c_test_find_timing(timings, plan->entries + i);
+		items[i].index = i;
+		items[i].weight = 0;
+		if (NULL != timing) {
+			// Never let a test weigh nothing, or ties would pile up on the first shard.
+			items[i].weight = timing->duration_ns + 1;
+			known_duration_ns += items[i].weight;
+			known_count++;
+		}
+	}
+
+	// Tests added since the timings were recorded are assumed to be average.
+	const uint64_t default_weight = known_count == 0 ? 1 : known_duration_ns / known_count;
+	for (uint32_t i = 0; i < plan->count; i++) {
+		if (0 == items[i].weight) {
+			items[i].weight = default_weight;
+		}
+	}
+	qsort(items, plan->count, sizeof(c_test_shard_item_t), c_test_compare_shard_items);
+
+	uint64_t *loads = (uint64_t*)c_test_arena_calloc(&plan->arena, total_shards, sizeof(uint64_t));
+	for (uint32_t i = 0; i < plan->count; i++) {
+		uint32_t lightest_shard = 0;
+		for (uint32_t shard = 1; shard < total_shards; shard++) {
+			if (loads[shard] < loads[lightest_shard]) {
+				lightest_shard = shard;
+			}
+		}
+		loads[lightest_shard] += items[i].weight;
+		shards[items[i].index] = lightest_shard;
+	}
+}
+
+// Keeps only the tests of shard_index, in their original order.
+void c_test_plan_shard(c_test_plan_t *plan, uint32_t total_shards, uint32_t shard_index, 
+					   const char *shard_timings_path) {
+	if (total_shards <= 1) {
+		return;
+	}
+
+	uint32_t *shards = (uint32_t*)c_test_arena_alloc(&plan->arena, sizeof(uint32_t) * (plan->count + 1));
+	c_test_vector_t timings;
+	if (NULL != shard_timings_path && c_test_read_timings(shard_timings_path, &timings)) {
+		c_test_assign_weighted_shards(plan, &timings, total_shards, shards);
+		c_test_vector_destroy(&timings);
+	} else {
+		for (uint32_t i = 0; i < plan->count; i++) {
+			shards[i] = i % total_shards;
+		}
+	}
+
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < plan->count; i++) {
+		if (shards[i] == shard_index) {
+			plan->entries[count++] = plan->entries[i];
+		}
+	}
+	plan->count = count;
+}
+
+
+// === Repeating and shuffling === //
+
+// SplitMix64, enough to shuffle reproducibly from a single seed.
+uint64_t c_test_next_random(uint64_t *state) {
+	uint64_t value = (*state += 0x9E3779B97F4A7C15ULL);
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+	return value ^ (value >> 31);
+}
+
+uint64_t c_test_choose_shuffle_seed() {
+	uint64_t state = c_test_monotonic_ns() ^ ((uint64_t)time(NULL) << 32);
+	const uint64_t seed = c_test_next_random(&state);
+	return 0 == seed ? 1 : seed;
+}
+
+// Runs every entry repeat_count times, each repetition of the plan after the previous one.
+int c_test_plan_repeat(c_test_plan_t *plan, uint32_t repeat_count) {
+	if (repeat_count <= 1) {
+		return 1;
+	}
+	const uint64_t count = (uint64_t)plan->count * repeat_count;
+	if (count > UINT32_MAX) {
+		fprintf(stderr, "c_test: %u repetitions of %u tests are too many to run\n", repeat_count, plan->count);
+		return 0;
+	}
+
+	c_test_plan_entry_t *entries = (c_test_plan_entry_t*)c_test_arena_alloc(&plan->arena, 
+																			 sizeof(c_test_plan_entry_t) * count);
+	for (uint32_t i = 0; i < repeat_count; i++) {
+		memcpy(entries + (uint64_t)i * plan->count, plan->entries, sizeof(c_test_plan_entry_t) * plan->count);
+	}
+	plan->entries = entries;
+	plan->results = (c_test_result_t*)c_test_arena_calloc(&plan->arena, count, sizeof(c_test_result_t));
+	plan->count = (uint32_t)count;
+	return 1;
+}
+
+void c_test_plan_shuffle(c_test_plan_t *plan, uint64_t seed) {
+	uint64_t state = seed;
+	for (uint32_t i = plan->count; i > 1; i--) {
+		const uint32_t j = (uint32_t)(c_test_next_random(&state) % i);
+		const c_test_plan_entry_t entry = plan->entries[i - 1];
+		plan->entries[i - 1] = plan->entries[j];
+		plan->entries[j] = entry;
+	}
+}
+
+typedef struct {
+	const c_test_definition_t *definition;
+	uint32_t case_index;
+	uint64_t duration_ns;
+	int success;
+} c_test_repetition_t;
+
+int c_test_compare_repetitions(const void *a, const void *b) {
+	const c_test_repetition_t *lhs = a;
+	const c_test_repetition_t *rhs = b;
+	if (lhs->definition != rhs->definition) {
+		return lhs->definition < rhs->definition ? -1 : 1;
+	}
+	if (lhs->case_index != rhs->case_index) {
+		return lhs->case_index < rhs->case_index ? -1 : 1;
+	}
+	return (lhs->duration_ns > rhs->duration_ns) - (lhs->duration_ns < rhs->duration_ns);
+}
+
+// Prints how often each test passed across its repetitions and the spread of its durations, in registration order, to
+// stderr so that stdout carries only what the runner writes.
+void c_test_print_repetitions(c_test_plan_t *plan) {
+	c_test_repetition_t *repetitions = 
+		(c_test_repetition_t*)c_test_arena_alloc(&plan->arena, sizeof(c_test_repetition_t) * (plan->count + 1));
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < plan->count; i++) {
+		if (plan->results[i].skipped) {
+			continue;
+		}
+		repetitions[count].definition = plan->entries[i].definition;
+		repetitions[count].case_index = plan->entries[i].case_index;
+		repetitions[count].duration_ns = plan->results[i].duration_ns;
+		repetitions[count].success = plan->results[i].success;
+		count++;
+	}
+	qsort(repetitions, count, sizeof(c_test_repetition_t), c_test_compare_repetitions);
+
+	fflush(stdout);
+	fprintf(stderr, "\n");
+	uint32_t begin = 0;
+	while (begin < count) {
+		uint32_t end = begin;
+		uint32_t passed_count = 0;
+		while (end < count && repetitions[end].definition == repetitions[begin].definition && 
+			   repetitions[end].case_index == repetitions[begin].case_index) {
+			passed_count += repetitions[end].success;
+			end++;
+		}
+
+		const uint32_t run_count = end - begin;
+		const uint32_t middle = begin + run_count / 2;
+		const double median_ns = run_count % 2 == 1 ? repetitions[middle].duration_ns : 
+			(repetitions[middle - 1].duration_ns + repetitions[middle].duration_ns) / 2.0;
+		char suffix[C_TEST_CASE_SUFFIX_SIZE];
+		fprintf(stderr, "%s %s.%s%s passed %u/%u, min %.3f ms, median %.3f ms, max %.3f ms\n", 
+				passed_count == run_count ? "[ REPEATED ]" : 0 == passed_count ? "[  FAILED  ]" : "[  FLAKY   ]", 
+				repetitions[begin].definition->name_space, repetitions[begin].definition->test_name, 
+				c_test_case_suffix(repetitions[begin].definition, repetitions[begin].case_index, suffix, 
+								   sizeof(suffix)), 
+				passed_count, run_count, repetitions[begin].duration_ns / 1e6, median_ns / 1e6, 
+				repetitions[end - 1].duration_ns / 1e6);
+		begin = end;
+	}
+}
+
+
+// === Assertions from any thread === //
+
+// Test bodies get a proxy for the runner running them. Assertions on the test's own thread go straight to that runner,
+// while those made on threads the test spawned are formatted on their thread and pushed onto a lock-free stack, which
+// the test's thread drains into the runner once the body returns. The proxy's error_count is updated atomically so a
+// test can still read it while its threads run.
+
+typedef struct c_test_thread_message {
+	struct c_test_thread_message *next;
+	int is_failure;
+	const char *expression;
+	const char *file_name;
+	int line_number;
+	char text[];
+} c_test_thread_message_t;
+
+typedef struct {
+	c_test_runner_t runner;
+	c_test_runner_t *target;
+	c_test_thread_message_t *messages;
+} c_test_proxy_t;
+
+// The proxy whose test runs on this thread.
+static __thread c_test_proxy_t *c_test_current_proxy;
+
+__thread uint64_t c_test_passed_assertions __attribute__((tls_model("initial-exec")));
+
+// Formats a message and reports it through target.
+void c_test_forward_message(c_test_runner_t *target, int is_failure, const char *expression, const char *file_name, 
+							int line_number, const char *format, va_list args) {
+	char buffer[1024];
+	va_list size_args;
+	va_copy(size_args, args);
+	const int text_size = vsnprintf(buffer, sizeof(buffer), format, size_args);
+	va_end(size_args);
+
+	char *text = buffer;
+	if (text_size >= (int)sizeof(buffer)) {
+		const int tracking = c_test_suspend_allocation_tracking();
+		text = (char*)malloc(text_size + 1);
+		c_test_resume_allocation_tracking(tracking);
+		vsnprintf(text, text_size + 1, format, args);
+	}
+	if (is_failure) {
+		target->failure(target, expression, file_name, line_number, "%s", text);
+	} else {
+		target->error(target, expression, file_name, line_number, "%s", text);
+	}
+	if (text != buffer) {
+		const int tracking = c_test_suspend_allocation_tracking();
+		free(text);
+		c_test_resume_allocation_tracking(tracking);
+	}
+}
+
+void c_test_proxy_message(c_test_runner_t *runner, int is_failure, const char *expression, const char *file_name, 
+						  int line_number, const char *format, va_list args) {
+	c_test_proxy_t *proxy = runner->data;
+	__atomic_fetch_add(&proxy->runner.error_count, 1, __ATOMIC_RELAXED);
+
+	if (c_test_current_proxy == proxy) {
+		c_test_forward_message(proxy->target, is_failure, expression, file_name, line_number, format, args);
+		return;
+	}
+
+	char buffer[1024];
+	va_list size_args;
+	va_copy(size_args, args);
+	const int text_size = vsnprintf(buffer, sizeof(buffer), format, size_args);
+	va_end(size_args);
+
+	// Allocations are only tracked on the test's own thread, so this one does not count against the test.
+	c_test_thread_message_t *message = (c_test_thread_message_t*)malloc(sizeof(c_test_thread_message_t) + text_size + 1);
+	message->is_failure = is_failure;
+	message->expression = expression;
+	message->file_name = file_name;
+	message->line_number = line_number;
+	if (text_size >= (int)sizeof(buffer)) {
+		vsnprintf(message->text, text_size + 1, format, args);
+	} else {
+		memcpy(message->text, buffer, text_size + 1);
+	}
+
+	message->next = __atomic_load_n(&proxy->messages, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&proxy->messages, &message->next, message, 1, __ATOMIC_RELEASE, 
+										__ATOMIC_RELAXED)) {
+	}
+}
+
+void c_test_proxy_failure(c_test_runner_t *runner, const char *expression, const char *file_name, int line_number, 
+						  const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	c_test_proxy_message(runner, 1, expression, file_name, line_number, format, args);
+	va_end(args);
+}
+
+void c_test_proxy_error(c_test_runner_t *runner, const char *expression, const char *file_name, int line_number, 
+						const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	c_test_proxy_message(runner, 0, expression, file_name, line_number, format, args);
+	va_end(args);
+}
+
+void c_test_proxy_begin(c_test_proxy_t *proxy, c_test_runner_t *target) {
+	proxy->target = target;
+	proxy->messages = NULL;
+	proxy->runner = (c_test_runner_t){
+		.failure = c_test_proxy_failure,
+		.success = NULL,
+		.passed = NULL,
+		.error = c_test_proxy_error,
+
+		.begin_test = NULL,
+		.end_test = NULL,
+		.skip_test = NULL,
+
+		.begin_tests = NULL,
+		.end_tests = NULL,
+
+		.benchmark_result = NULL,
+
+		.destroy = NULL,
+
+		.error_count = target->error_count,
+		.data = proxy,
+		.current_test = target->current_test,
+		.current_case = target->current_case,
+		.current_result = NULL,
+	};
+	c_test_current_proxy = proxy;
+}
+
+// Reports the messages of the test's other threads in the order they were made. Those threads must have finished.
+void c_test_proxy_end(c_test_proxy_t *proxy) {
+	c_test_current_proxy = NULL;
+	c_test_thread_message_t *reversed = __atomic_exchange_n(&proxy->messages, NULL, __ATOMIC_ACQUIRE);
+	c_test_thread_message_t *message = NULL;
+	while (NULL != reversed) {
+		c_test_thread_message_t *next = reversed->next;
+		reversed->next = message;
+		message = reversed;
+		reversed = next;
+	}
+
+	c_test_runner_t *target = proxy->target;
+	while (NULL != message) {
+		c_test_thread_message_t *next = message->next;
+		if (message->is_failure) {
+			target->failure(target, message->expression, message->file_name, message->line_number, "%s", 
+							message->text);
+		} else {
+			target->error(target, message->expression, message->file_name, message->line_number, "%s", 
+						  message->text);
+		}
+		free(message);
+		message = next;
+	}
+}
+
+
+// === Assertion failures === //
+
+void c_test_failure(c_test_runner_t *runner, const char *expression, const char *file_name, int line_number, 
+					const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	c_test_forward_message(runner, 1, expression, file_name, line_number, format, args);
+	va_end(args);
+}
+
+void c_test_error(c_test_runner_t *runner, const char *expression, const char *file_name, int line_number, 
+				  const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	c_test_forward_message(runner, 0, expression, file_name, line_number, format, args);
+	va_end(args);
+}
+
+c_test_value_t c_test_signed_value(int64_t value) {
+	return (c_test_value_t){
+		.kind = C_TEST_VALUE_SIGNED,
+		.digits = 0,
+		.float_value = 0,
+		.value.signed_value = value,
+	};
+}
+
+c_test_value_t c_test_unsigned_value(uint64_t value) {
+	return (c_test_value_t){
+		.kind = C_TEST_VALUE_UNSIGNED,
+		.digits = 0,
+		.float_value = 0,
+		.value.unsigned_value = value,
+	};
+}
+
+c_test_value_t c_test_char_value(int value) {
+	return (c_test_value_t){
+		.kind = C_TEST_VALUE_CHAR,
+		.digits = 0,
+		.float_value = 0,
+		.value.signed_value = value,
+	};
+}
+
+c_test_value_t c_test_float_value(float value) {
+	return (c_test_value_t){
+		.kind = C_TEST_VALUE_FLOAT,
+		.digits = 9,
+		.float_value = value,
+	};
+}
+
+c_test_value_t c_test_double_value(double value) {
+	return (c_test_value_t){
+		.kind = C_TEST_VALUE_FLOAT,
+		.digits = 17,
+		.float_value = value,
+	};
+}
+
+c_test_value_t c_test_long_double_value(long double value) {
+	return (c_test_value_t){
+		.kind = C_TEST_VALUE_FLOAT,
+		.digits = 21,
+		.float_value = value,
+	};
+}
+
+c_test_value_t c_test_pointer_value(const void *value) {
+	return (c_test_value_t){
+		.kind = C_TEST_VALUE_POINTER,
+		.digits = 0,
+		.float_value = 0,
+		.value.pointer_value = value,
+	};
+}
+
+c_test_value_t c_test_string_value(const char *value) {
+	return (c_test_value_t){
+		.kind = C_TEST_VALUE_STRING,
+		.digits = 0,
+		.float_value = 0,
+		.value.string_value = value,
+	};
+}
+
+const char* c_test_print_value(c_test_arena_t *arena, const c_test_value_t *value) {
+	const int64_t signed_value = value->value.signed_value;
+	switch (value->kind) {
+	case C_TEST_VALUE_SIGNED:
+		return c_test_arena_printf(arena, "%lld", (long long)signed_value);
+	case C_TEST_VALUE_UNSIGNED:
+		return c_test_arena_printf(arena, "%llu", (unsigned long long)value->value.unsigned_value);
+	case C_TEST_VALUE_CHAR:
+		return isprint((int)signed_value) ? c_test_arena_printf(arena, "'%c' (%d)", (int)signed_value, (int)signed_value) : 
+			c_test_arena_printf(arena, "%d", (int)signed_value);
+	case C_TEST_VALUE_FLOAT:
+		return c_test_arena_printf(arena, "%.*Lg", value->digits, value->float_value);
+	case C_TEST_VALUE_POINTER:
+		return c_test_arena_printf(arena, "%p", value->value.pointer_value);
+	default:
+		return NULL == value->value.string_value ? "NULL" : 
+			c_test_arena_printf(arena, "\"%s\"", value->value.string_value);
+	}
+}
+
+void c_test_compare_failure(c_test_runner_t *runner, int is_failure, const char *expression, const char *file_name, 
+							int line_number, const char *a_text, const char *b_text, const c_test_value_t *values, 
+							const char *format, ...) {
+	const int tracking = c_test_suspend_allocation_tracking();
+	c_test_arena_t arena;
+	c_test_arena_init(&arena, 4096);
+
+	va_list args;
+	va_start(args, format);
+	const char *message = c_test_arena_vprintf(&arena, format, args);
+	va_end(args);
+
+	// Operands that are literals already show their value in the expression.
+	const char *a_value = c_test_print_value(&arena, values);
+	const char *b_value = c_test_print_value(&arena, values + 1);
+	const char *a_line = 0 == strcmp(a_text, a_value) ? "" : c_test_arena_printf(&arena, "\n  %s: %s", a_text, a_value);
+	const char *b_line = 0 == strcmp(b_text, b_value) ? "" : c_test_arena_printf(&arena, "\n  %s: %s", b_text, b_value);
+
+	if (is_failure) {
+		runner->failure(runner, expression, file_name, line_number, "%s%s%s", message, a_line, b_line);
+	} else {
+		runner->error(runner, expression, file_name, line_number, "%s%s%s", message, a_line, b_line);
+	}
+
+	c_test_arena_destroy(&arena);
+	c_test_resume_allocation_tracking(tracking);
+}
+
+void c_test_memeq_failure(c_test_runner_t *runner, int is_failure, const char *expression, const char *file_name, 
+						  int line_number, const void *a, const void *b, size_t size, const char *format, ...) {
+	const unsigned char *a_bytes = a;
+	const unsigned char *b_bytes = b;
+	size_t offset = 0;
+	while (offset < size && a_bytes[offset] == b_bytes[offset]) {
+		offset++;
+	}
+
+	const int tracking = c_test_suspend_allocation_tracking();
+	c_test_arena_t arena;
+	c_test_arena_init(&arena, 4096);
+
+	va_list args;
+	va_start(args, format);
+	const char *message = c_test_arena_vprintf(&arena, format, args);
+	va_end(args);
+
+	if (is_failure) {
+		runner->failure(runner, expression, file_name, line_number, 
+						"%s\n  first difference at offset %zu of %zu: 0x%02x != 0x%02x", message, offset, size, 
+						a_bytes[offset], b_bytes[offset]);
+	} else {
+		runner->error(runner, expression, file_name, line_number, 
+					  "%s\n  first difference at offset %zu of %zu: 0x%02x != 0x%02x", message, offset, size, 
+					  a_bytes[offset], b_bytes[offset]);
+	}
+
+	c_test_arena_destroy(&arena);
+	c_test_resume_allocation_tracking(tracking);
+}
+
+
+// === Running tests === //
+
+// The input fuzz targets receive when they run as tests, read from fuzz_input_path for the duration of a run.
+typedef struct {
+	uint8_t *data;
+	size_t size;
+} c_test_fuzz_input_t;
+
+c_test_fuzz_input_t* c_test_get_fuzz_input() {
+	static c_test_fuzz_input_t fuzz_input = {.data = NULL, .size = 0};
+	return &fuzz_input;
+}
+
+void c_test_run_test(c_test_runner_t *runner, void *data) {
+	if (NULL != runner->current_test->test_function) {
+		runner->current_test->test_function(runner);
+	} else if (NULL != runner->current_test->test_fixture_function) {
+		runner->current_test->test_fixture_function(runner, data);
+	} else if (NULL != runner->current_test->test_param_function) {
+		const c_test_definition_t *test_definition = runner->current_test;
+		test_definition->test_param_function(runner, (const char*)test_definition->params + 
+											 test_definition->param_size * runner->current_case);
+	} else if (NULL != runner->current_test->test_fuzz_function) {
+		// Empty inputs still point at a byte, since targets may hand data_ to functions rejecting NULL.
+		static const uint8_t empty_input[1] = {0};
+		const c_test_fuzz_input_t *fuzz_input = c_test_get_fuzz_input();
+		runner->current_test->test_fuzz_function(runner, NULL != fuzz_input->data ? fuzz_input->data : empty_input, 
+												 fuzz_input->size);
+	} else {
+		runner->failure(runner, "", __FILE__, __LINE__, "No valid test function for %s:%d", 
+						runner->current_test->file_name, runner->current_test->line_number);
+	}
+}
+
+// The shared fixture currently set up by one executor (the calling thread, a worker or a child process).
+typedef struct {
+	const c_test_fixture_t *fixture;
+	void *data;
+} c_test_suite_t;
+
+void c_test_suite_leave(c_test_suite_t *suite) {
+	if (NULL != suite->fixture && NULL != suite->fixture->teardown_suite) {
+		suite->fixture->teardown_suite(suite->data);
+	}
+	suite->fixture = NULL;
+	suite->data = NULL;
+}
+
+// Makes fixture the active shared fixture, tearing down the previous one, and returns its data.
+void* c_test_suite_enter(c_test_suite_t *suite, const c_test_fixture_t *fixture) {
+	if (suite->fixture != fixture) {
+		c_test_suite_leave(suite);
+		if (c_test_is_shared_fixture(fixture)) {
+			suite->fixture = fixture;
+			suite->data = fixture->setup_suite();
+		}
+	}
+	return suite->data;
+}
+
+// === Per-test timeout within the process === //
+
+// With C_TEST_USE_TIMEOUT_TIMER every thread running tests owns a POSIX timer that signals that thread alone. When a
+// test overruns, the handler jumps back out of the test body, which is then reported as failed. Anything the body was
+// doing at the time is abandoned, so locks it held stay locked and its teardown is not run; the run therefore stops
+// after the first timeout. Isolated runs enforce timeouts by killing the child process instead, and keep going.
+// The SIGALRM handler is only installed for the duration of a run, and the previous one is restored afterwards.
+
+#ifdef C_TEST_USE_TIMEOUT_TIMER
+
+typedef struct {
+	int initialized;
+	timer_t timer;
+	volatile sig_atomic_t armed;
+	sigjmp_buf jump;
+} c_test_watchdog_t;
+
+static __thread c_test_watchdog_t c_test_watchdog;
+
+typedef struct {
+	int installed;
+	struct sigaction previous_action;
+} c_test_watchdog_handler_t;
+
+c_test_watchdog_handler_t* c_test_get_watchdog_handler() {
+	static c_test_watchdog_handler_t handler = {
+		.installed = 0,
+	};
+	return &handler;
+}
+
+void c_test_watchdog_signal(int signal_number) {
+	if (c_test_watchdog.armed) {
+		c_test_watchdog.armed = 0;
+		siglongjmp(c_test_watchdog.jump, 1);
+	}
+}
+
+// Installs the SIGALRM handler before any test of the run starts.
+void c_test_watchdog_install() {
+	c_test_watchdog_handler_t *handler = c_test_get_watchdog_handler();
+	if (handler->installed) {
+		return;
+	}
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = c_test_watchdog_signal;
+	sigemptyset(&action.sa_mask);
+	handler->installed = 0 == sigaction(SIGALRM, &action, &handler->previous_action);
+}
+
+// Restores the SIGALRM handler found by c_test_watchdog_install, once every thread released its timer.
+void c_test_watchdog_uninstall() {
+	c_test_watchdog_handler_t *handler = c_test_get_watchdog_handler();
+	if (handler->installed) {
+		sigaction(SIGALRM, &handler->previous_action, NULL);
+		handler->installed = 0;
+	}
+}
+
+int c_test_watchdog_init(c_test_watchdog_t *watchdog) {
+	if (watchdog->initialized) {
+		return 1;
+	}
+	if (!c_test_get_watchdog_handler()->installed) {
+		return 0;
+	}
+
+	struct sigevent event;
+	memset(&event, 0, sizeof(event));
+	event.sigev_notify = SIGEV_THREAD_ID;
+	event.sigev_signo = SIGALRM;
+	event.sigev_notify_thread_id = syscall(SYS_gettid);
+	if (0 != timer_create(CLOCK_MONOTONIC, &event, &watchdog->timer)) {
+		return 0;
+	}
+	watchdog->armed = 0;
+	watchdog->initialized = 1;
+	return 1;
+}
+
+void c_test_watchdog_release() {
+	if (c_test_watchdog.initialized) {
+		timer_delete(c_test_watchdog.timer);
+		c_test_watchdog.initialized = 0;
+	}
+}
+
+void c_test_watchdog_arm(c_test_watchdog_t *watchdog, uint32_t timeout_ms) {
+	struct itimerspec timer_spec;
+	memset(&timer_spec, 0, sizeof(timer_spec));
+	timer_spec.it_value.tv_sec = timeout_ms / 1000;
+	timer_spec.it_value.tv_nsec = (timeout_ms % 1000) * 1000000L;
+	watchdog->armed = 1;
+	timer_settime(watchdog->timer, 0, &timer_spec, NULL);
+}
+
+void c_test_watchdog_disarm(c_test_watchdog_t *watchdog) {
+	// Disarm first so a signal arriving now no longer jumps.
+	watchdog->armed = 0;
+	struct itimerspec timer_spec;
+	memset(&timer_spec, 0, sizeof(timer_spec));
+	timer_settime(watchdog->timer, 0, &timer_spec, NULL);
+}
+
+// Runs the test body, returns non-zero when it was abandoned after timeout_ms.
+int c_test_run_test_with_timeout(c_test_runner_t *runner, void *data, uint32_t timeout_ms) {
+	c_test_watchdog_t *watchdog = &c_test_watchdog;
+	if (!c_test_watchdog_init(watchdog)) {
+		c_test_run_test(runner, data);
+		return 0;
+	}
+	if (0 != sigsetjmp(watchdog->jump, 1)) {
+		c_test_watchdog_disarm(watchdog);
+		return 1;
+	}
+	c_test_watchdog_arm(watchdog, timeout_ms);
+	c_test_run_test(runner, data);
+	c_test_watchdog_disarm(watchdog);
+	return 0;
+}
+
+#else
+
+void c_test_watchdog_install() {
+}
+
+void c_test_watchdog_uninstall() {
+}
+
+void c_test_watchdog_release() {
+}
+
+int c_test_run_test_with_timeout(c_test_runner_t *runner, void *data, uint32_t timeout_ms) {
+	c_test_run_test(runner, data);
+	return 0;
+}
+
+#endif
+
+uint32_t c_test_run_definition(c_test_runner_t *runner, c_test_plan_t *plan, c_test_suite_t *suite, 
+							   const c_test_plan_entry_t *entry, c_test_result_t *result) {
+	const c_test_options_t *options = plan->options;
+	const c_test_definition_t *test_definition = entry->definition;
+	c_test_setup_function_t setup_function = test_definition->setup;
+	c_test_teardown_function_t teardown_function = test_definition->teardown;
+	void *data_ = NULL;
+
+	runner->current_test = test_definition;
+	runner->current_case = entry->case_index;
+
+	if (c_test_is_shared_fixture(test_definition->fixture)) {
+		data_ = c_test_suite_enter(suite, test_definition->fixture);
+		if (NULL != test_definition->fixture->reset) {
+			test_definition->fixture->reset(data_);
+		}
+		setup_function = NULL;
+		teardown_function = NULL;
+	} else {
+		c_test_suite_leave(suite);
+	}
+
+	if (NULL != setup_function) {
+		data_ = setup_function();
+	}
+
+	const uint32_t start_error_count = runner->error_count;
+
+	if (NULL != runner->begin_test) {
+		runner->begin_test(runner);
+	}
+
+	c_test_clock_sample_t start_sample;
+	c_test_clock_sample_t end_sample;
+	c_test_counter_sample_t start_counters;
+	c_test_counter_sample_t end_counters;
+	// Sampled first so that opening the counters on a thread's first test is not timed.
+	c_test_sample_counters(&start_counters);
+	c_test_sample_start_clocks(&start_sample);
+	c_test_begin_allocation_tracking();
+	c_test_proxy_t proxy;
+	c_test_proxy_begin(&proxy, runner);
+	const uint64_t start_passed_assertions = c_test_passed_assertions;
+	int timed_out = 0;
+	// Isolated runs enforce the timeout from the parent process.
+	if (0 != options->timeout_ms && !options->isolate) {
+		timed_out = c_test_run_test_with_timeout(&proxy.runner, data_, options->timeout_ms);
+	} else {
+		c_test_run_test(&proxy.runner, data_);
+	}
+	c_test_end_allocation_tracking(result);
+	c_test_sample_end_clocks(&end_sample);
+	c_test_sample_counters(&end_counters);
+	c_test_proxy_end(&proxy);
+
+	if (timed_out) {
+		runner->failure(runner, "", test_definition->file_name, test_definition->line_number, 
+						"Test timed out after %u ms, stopping the run", options->timeout_ms);
+		__atomic_store_n(&plan->timed_out, 1, __ATOMIC_RELAXED);
+		// The body stopped halfway, so its data is left as it is.
+		teardown_function = NULL;
+	}
+
+	if (options->fail_on_leaks && result->unfreed_bytes > 0) {
+		runner->failure(runner, "", test_definition->file_name, test_definition->line_number, 
+						"Test leaked %llu bytes in %llu allocations", (unsigned long long)result->unfreed_bytes, 
+						(unsigned long long)result->unfreed_allocation_count);
+	}
+
+	const int test_success = start_error_count == runner->error_count;
+	result->success = test_success;
+	result->skipped = 0;
+	c_test_result_from_samples(result, &start_sample, &end_sample);
+	c_test_counters_from_samples(&result->counters, &start_counters, &end_counters);
+	result->passed_assertion_count = c_test_passed_assertions - start_passed_assertions;
+
+	c_test_report_passes(runner, result->passed_assertion_count);
+
+	if (NULL != runner->end_test) {
+		runner->current_result = result;
+		runner->end_test(runner, test_success);
+		runner->current_result = NULL;
+	}
+
+	if (NULL != teardown_function) {
+		teardown_function(data_);
+	}
+
+	runner->current_test = NULL;
+	return test_success;
+}
+
+// Reports a test the run stopped before reaching.
+void c_test_skip_entry(c_test_runner_t *runner, const c_test_plan_entry_t *entry, c_test_result_t *result) {
+	memset(result, 0, sizeof(c_test_result_t));
+	result->success = 1;
+	result->skipped = 1;
+	if (NULL != runner->skip_test) {
+		runner->current_test = entry->definition;
+		runner->current_case = entry->case_index;
+		runner->skip_test(runner);
+		runner->current_test = NULL;
+	}
+}
+
+uint32_t c_test_run_serial(c_test_runner_t *runner, c_test_plan_t *plan) {
+	c_test_suite_t suite = {
+		.fixture = NULL,
+		.data = NULL,
+	};
+	uint32_t failed_test_count = 0;
+	for (uint32_t i = 0; i < plan->count; i++) {
+		if (c_test_plan_should_stop(plan, failed_test_count)) {
+			c_test_skip_entry(runner, plan->entries + i, plan->results + i);
+		} else if (!c_test_run_definition(runner, plan, &suite, plan->entries + i, plan->results + i)) {
+			failed_test_count++;
+		}
+	}
+	c_test_suite_leave(&suite);
+	c_test_watchdog_release();
+	c_test_counters_release();
+	return failed_test_count;
+}
+
+
+// === Captured test results === //
+
+// Tests that run away from the calling thread (on a worker thread or in a child process) record their messages
+// into a slot, which is later replayed into the user's runner as if the test had run there.
+
+typedef struct c_test_message {
+	struct c_test_message *next;
+
+	int is_failure;
+	const char *expression;
+	const char *file_name;
+	int line_number;
+	const char *text;
+} c_test_message_t;
+
+typedef struct {
+	int done;
+	c_test_result_t result;
+
+	c_test_message_t *first_message;
+	c_test_message_t *last_message;
+} c_test_slot_t;
+
+void c_test_slot_append_message(c_test_slot_t *slot, c_test_message_t *message) {
+	message->next = NULL;
+	if (NULL == slot->last_message) {
+		slot->first_message = message;
+	} else {
+		slot->last_message->next = message;
+	}
+	slot->last_message = message;
+}
+
+void c_test_replay_slot(c_test_runner_t *runner, const c_test_plan_entry_t *entry, c_test_slot_t *slot) {
+	runner->current_test = entry->definition;
+	runner->current_case = entry->case_index;
+
+	if (NULL != runner->begin_test) {
+		runner->begin_test(runner);
+	}
+
+	c_test_message_t *message = slot->first_message;
+	while (NULL != message) {
+		if (message->is_failure) {
+			runner->failure(runner, message->expression, message->file_name, message->line_number, "%s", 
+							message->text);
+		} else {
+			runner->error(runner, message->expression, message->file_name, message->line_number, "%s", 
+						  message->text);
+		}
+		message = message->next;
+	}
+	slot->first_message = NULL;
+	slot->last_message = NULL;
+
+	c_test_report_passes(runner, slot->result.passed_assertion_count);
+
+	if (NULL != runner->end_test) {
+		runner->current_result = &slot->result;
+		runner->end_test(runner, slot->result.success);
+		runner->current_result = NULL;
+	}
+
+	runner->current_test = NULL;
+}
+
+
+// === Running tests on a pool of worker threads === //
+
+#ifdef C_TEST_USE_THREADS
+
+// Each worker runs tests against its own clone of the user's runner, whose failure and error callbacks capture the
+// formatted messages into the test's slot. The calling thread then replays every slot into the user's runner in
+// registration order, so output is identical to a serial run no matter which worker finished first.
+
+typedef struct {
+	c_test_plan_t *plan;
+	c_test_slot_t *slots;
+
+	// Workers claim whole chunks: all consecutive tests of one shared fixture, or a single test otherwise. 
+	// chunk_starts holds chunk_count + 1 boundaries.
+	uint32_t *chunk_starts;
+	uint32_t chunk_count;
+	uint32_t next_chunk;
+
+	// Set once the merger decides the run stops early. Workers then skip instead of running.
+	int stopped;
+
+	int merger_waiting;
+	pthread_mutex_t mutex;
+	pthread_cond_t condition;
+} c_test_pool_t;
+
+typedef struct {
+	c_test_pool_t *pool;
+	// Messages captured by this worker, released once the pool has replayed them.
+	c_test_arena_t arena;
+	c_test_runner_t runner;
+	c_test_suite_t suite;
+	c_test_slot_t *current_slot;
+	pthread_t thread;
+} c_test_worker_t;
+
+void c_test_capture_message(c_test_runner_t *runner, int is_failure, const char *expression, const char *file_name, 
+							int line_number, const char *format, va_list args) {
+	c_test_worker_t *worker = runner->data;
+	c_test_message_t *message = (c_test_message_t*)c_test_arena_alloc(&worker->arena, sizeof(c_test_message_t));
+	message->is_failure = is_failure;
+	message->expression = expression;
+	message->file_name = file_name;
+	message->line_number = line_number;
+	message->text = c_test_arena_vprintf(&worker->arena, format, args);
+
+	c_test_slot_append_message(worker->current_slot, message);
+
+	runner->error_count++;
+}
+
+void c_test_capture_failure(c_test_runner_t *runner, const char *expression, const char *file_name, int line_number, 
+							const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	c_test_capture_message(runner, 1, expression, file_name, line_number, format, args);
+	va_end(args);
+}
+
+void c_test_capture_error(c_test_runner_t *runner, const char *expression, const char *file_name, int line_number, 
+						  const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	c_test_capture_message(runner, 0, expression, file_name, line_number, format, args);
+	va_end(args);
+}
+
+void c_test_capture_success(c_test_runner_t *runner, const char *file_name, int line_number) {
+}
+
+void c_test_capture_passed(c_test_runner_t *runner, uint64_t passed_count) {
+}
+
+void* c_test_worker_main(void *argument) {
+	c_test_worker_t *worker = argument;
+	c_test_pool_t *pool = worker->pool;
+
+	for (;;) {
+		const uint32_t chunk = __atomic_fetch_add(&pool->next_chunk, 1, __ATOMIC_RELAXED);
+		if (chunk >= pool->chunk_count) {
+			break;
+		}
+
+		for (uint32_t index = pool->chunk_starts[chunk]; index < pool->chunk_starts[chunk + 1]; index++) {
+			c_test_slot_t *slot = pool->slots + index;
+			if (__atomic_load_n(&pool->stopped, __ATOMIC_RELAXED) || c_test_plan_should_stop(pool->plan, 0)) {
+				slot->result.success = 1;
+				slot->result.skipped = 1;
+			} else {
+				worker->current_slot = slot;
+				c_test_run_definition(&worker->runner, pool->plan, &worker->suite, pool->plan->entries + index, 
+									  &slot->result);
+				worker->current_slot = NULL;
+			}
+
+			__atomic_store_n(&slot->done, 1, __ATOMIC_SEQ_CST);
+			if (__atomic_load_n(&pool->merger_waiting, __ATOMIC_SEQ_CST)) {
+				pthread_mutex_lock(&pool->mutex);
+				pthread_cond_broadcast(&pool->condition);
+				pthread_mutex_unlock(&pool->mutex);
+			}
+		}
+	}
+
+	c_test_suite_leave(&worker->suite);
+	c_test_watchdog_release();
+	c_test_counters_release();
+	return NULL;
+}
+
+void c_test_pool_wait_for_slot(c_test_pool_t *pool, c_test_slot_t *slot) {
+	while (!__atomic_load_n(&slot->done, __ATOMIC_SEQ_CST)) {
+		pthread_mutex_lock(&pool->mutex);
+		__atomic_store_n(&pool->merger_waiting, 1, __ATOMIC_SEQ_CST);
+		if (!__atomic_load_n(&slot->done, __ATOMIC_SEQ_CST)) {
+			pthread_cond_wait(&pool->condition, &pool->mutex);
+		}
+		__atomic_store_n(&pool->merger_waiting, 0, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock(&pool->mutex);
+	}
+}
+
+uint32_t c_test_run_pool(c_test_runner_t *runner, c_test_plan_t *plan, uint32_t worker_count) {
+	const uint32_t count = plan->count;
+	if (worker_count > count) {
+		worker_count = count;
+	}
+	if (worker_count <= 1) {
+		return c_test_run_serial(runner, plan);
+	}
+
+	c_test_pool_t pool = {
+		.plan = plan,
+		.slots = (c_test_slot_t*)c_test_arena_calloc(&plan->arena, count, sizeof(c_test_slot_t)),
+		.chunk_starts = (uint32_t*)c_test_arena_alloc(&plan->arena, sizeof(uint32_t) * (count + 1)),
+		.chunk_count = 0,
+		.next_chunk = 0,
+		.stopped = 0,
+		.merger_waiting = 0,
+	};
+	for (uint32_t i = 0; i < count; i++) {
+		const c_test_fixture_t *fixture = plan->entries[i].definition->fixture;
+		if (0 == i || !c_test_is_shared_fixture(fixture) || fixture != plan->entries[i - 1].definition->fixture) {
+			pool.chunk_starts[pool.chunk_count++] = i;
+		}
+	}
+	pool.chunk_starts[pool.chunk_count] = count;
+	pthread_mutex_init(&pool.mutex, NULL);
+	pthread_cond_init(&pool.condition, NULL);
+
+	c_test_worker_t *workers = (c_test_worker_t*)calloc(worker_count, sizeof(c_test_worker_t));
+	uint32_t started_count = 0;
+	for (uint32_t i = 0; i < worker_count; i++) {
+		c_test_worker_t *worker = workers + i;
+		worker->pool = &pool;
+		c_test_arena_init(&worker->arena, kDefaultArenaBlockSize);
+		worker->suite.fixture = NULL;
+		worker->suite.data = NULL;
+		worker->runner = (c_test_runner_t){
+			.failure = c_test_capture_failure,
+			.success = c_test_capture_success,
+			.passed = c_test_capture_passed,
+			.error = c_test_capture_error,
+
+			.begin_test = NULL,
+			.end_test = NULL,
+			.skip_test = NULL,
+
+			.begin_tests = NULL,
+			.end_tests = NULL,
+
+			.benchmark_result = NULL,
+
+			.destroy = NULL,
+
+			.error_count = 0,
+			.data = worker,
+			.current_test = NULL,
+			.current_case = 0,
+			.current_result = NULL,
+		};
+		if (0 != pthread_create(&worker->thread, NULL, c_test_worker_main, worker)) {
+			break;
+		}
+		started_count++;
+	}
+
+	uint32_t failed_test_count = 0;
+	if (0 == started_count) {
+		failed_test_count = c_test_run_serial(runner, plan);
+	} else {
+		for (uint32_t i = 0; i < count; i++) {
+			if (c_test_plan_should_stop(plan, failed_test_count)) {
+				__atomic_store_n(&pool.stopped, 1, __ATOMIC_RELAXED);
+			}
+			// Once stopped, workers mark the tests they have not started as skipped, but tests already running or
+			// finished still report their results.
+			c_test_pool_wait_for_slot(&pool, pool.slots + i);
+			if (pool.slots[i].result.skipped) {
+				c_test_skip_entry(runner, plan->entries + i, plan->results + i);
+				continue;
+			}
+
+			c_test_replay_slot(runner, plan->entries + i, pool.slots + i);
+			plan->results[i] = pool.slots[i].result;
+			if (!pool.slots[i].result.success) {
+				failed_test_count++;
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < started_count; i++) {
+		pthread_join(workers[i].thread, NULL);
+	}
+	for (uint32_t i = 0; i < worker_count; i++) {
+		c_test_arena_destroy(&workers[i].arena);
+	}
+
+	free(workers);
+	pthread_cond_destroy(&pool.condition);
+	pthread_mutex_destroy(&pool.mutex);
+	return failed_test_count;
+}
+
+uint32_t c_test_online_cpu_count() {
+	long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+	return cpu_count > 0 ? (uint32_t)cpu_count : 1;
+}
+
+#else
+
+uint32_t c_test_run_pool(c_test_runner_t *runner, c_test_plan_t *plan, uint32_t worker_count) {
+	return c_test_run_serial(runner, plan);
+}
+
+uint32_t c_test_online_cpu_count() {
+	return 1;
+}
+
+#endif
+
+
+// === Running tests in forked child processes === //
+
+#ifdef C_TEST_USE_FORK
+
+// Children run a batch of consecutive tests and stream a compact binary record back over a pipe for every message
+// and every finished test, the latter followed by its c_test_result_t. The parent multiplexes the pipes with poll, so
+// a crash, a non-zero exit or a timeout is attributed to the first test of the batch that has not reported a result,
+// and the rest of the batch is handed to a fresh child.
+
+enum {
+	C_TEST_RECORD_FAILURE = 1,
+	C_TEST_RECORD_ERROR = 2,
+	C_TEST_RECORD_END = 3,
+};
+
+typedef struct {
+	uint32_t type;
+	uint32_t index;
+	// Line number for messages.
+	int32_t value;
+	uint32_t expression_size;
+	uint32_t file_name_size;
+	uint32_t text_size;
+} c_test_record_header_t;
+
+typedef struct {
+	int fd;
+	uint32_t index;
+	c_test_arena_t arena;
+} c_test_child_writer_t;
+
+typedef struct {
+	pid_t pid;
+	int fd;
+
+	// The first test of the batch without a result, and one past the last test of the batch.
+	uint32_t next_index;
+	uint32_t end_index;
+	uint64_t test_start_ns;
+
+	char *buffer;
+	size_t buffer_size;
+	size_t buffer_capacity;
+} c_test_child_t;
+
+void c_test_write_all(int fd, const char *data, size_t size) {
+	while (size > 0) {
+		ssize_t written = write(fd, data, size);
+		if (written < 0) {
+			if (EINTR == errno) {
+				continue;
+			}
+			return;
+		}
+		data += written;
+		size -= written;
+	}
+}
+
+void c_test_child_write_message(c_test_runner_t *runner, uint32_t type, const char *expression, 
+								const char *file_name, int line_number, const char *format, va_list args) {
+	c_test_child_writer_t *writer = runner->data;
+
+	va_list size_args;
+	va_copy(size_args, args);
+	const uint32_t text_size = vsnprintf(NULL, 0, format, size_args);
+	va_end(size_args);
+
+	c_test_record_header_t header = {
+		.type = type,
+		.index = writer->index,
+		.value = line_number,
+		.expression_size = strlen(expression),
+		.file_name_size = strlen(file_name),
+		.text_size = text_size,
+	};
+
+	const size_t record_size = sizeof(header) + header.expression_size + header.file_name_size + text_size;
+	char *record = (char*)c_test_arena_alloc(&writer->arena, record_size + 1);
+	char *cursor = record;
+	memcpy(cursor, &header, sizeof(header));
+	cursor += sizeof(header);
+	memcpy(cursor, expression, header.expression_size);
+	cursor += header.expression_size;
+	memcpy(cursor, file_name, header.file_name_size);
+	cursor += header.file_name_size;
+	vsnprintf(cursor, text_size + 1, format, args);
+
+	c_test_write_all(writer->fd, record, record_size);
+
+	runner->error_count++;
+}
+
+void c_test_child_failure(c_test_runner_t *runner, const char *expression, const char *file_name, int line_number, 
+						  const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	c_test_child_write_message(runner, C_TEST_RECORD_FAILURE, expression, file_name, line_number, format, args);
+	va_end(args);
+}
+
+void c_test_child_error(c_test_runner_t *runner, const char *expression, const char *file_name, int line_number, 
+						const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	c_test_child_write_message(runner, C_TEST_RECORD_ERROR, expression, file_name, line_number, format, args);
+	va_end(args);
+}
+
+void c_test_child_success(c_test_runner_t *runner, const char *file_name, int line_number) {
+}
+
+void c_test_child_passed(c_test_runner_t *runner, uint64_t passed_count) {
+}
+
+void c_test_child_main(int fd, c_test_plan_t *plan, uint32_t begin_index, uint32_t end_index) {
+	// An inherited counter group would keep counting the parent's thread.
+	c_test_counters_release();
+	c_test_child_writer_t writer = {
+		.fd = fd,
+		.index = begin_index,
+	};
+	c_test_arena_init(&writer.arena, kDefaultArenaBlockSize);
+	c_test_suite_t suite = {
+		.fixture = NULL,
+		.data = NULL,
+	};
+	c_test_runner_t runner = {
+		.failure = c_test_child_failure,
+		.success = c_test_child_success,
+		.passed = c_test_child_passed,
+		.error = c_test_child_error,
+
+		.begin_test = NULL,
+		.end_test = NULL,
+		.skip_test = NULL,
+
+		.begin_tests = NULL,
+		.end_tests = NULL,
+
+		.benchmark_result = NULL,
+
+		.destroy = NULL,
+
+		.error_count = 0,
+		.data = &writer,
+		.current_test = NULL,
+		.current_case = 0,
+		.current_result = NULL,
+	};
+
+	for (uint32_t i = begin_index; i < end_index; i++) {
+		writer.index = i;
+		struct {
+			c_test_record_header_t header;
+			c_test_result_t result;
+		} record = {
+			.header = {
+				.type = C_TEST_RECORD_END,
+				.index = i,
+			},
+		};
+		c_test_run_definition(&runner, plan, &suite, plan->entries + i, &record.result);
+		// Keep the test's own output if a later test in the batch takes the process down.
+		fflush(NULL);
+
+		c_test_write_all(fd, (const char*)&record, sizeof(record));
+	}
+
+	c_test_suite_leave(&suite);
+	fflush(NULL);
+
+	_exit(0);
+}
+
+void c_test_child_spawn(c_test_child_t *child, c_test_plan_t *plan, uint32_t begin_index, 
+						uint32_t end_index) {
+	child->pid = 0;
+	child->fd = -1;
+	child->next_index = begin_index;
+	child->end_index = end_index;
+	child->buffer_size = 0;
+	child->test_start_ns = c_test_monotonic_ns();
+
+	int fds[2];
+	if (0 != pipe(fds)) {
+		return;
+	}
+
+	// Anything still buffered would otherwise be written once by the parent and once more by the child.
+	fflush(NULL);
+
+	pid_t pid = fork();
+	if (0 == pid) {
+		close(fds[0]);
+		c_test_child_main(fds[1], plan, begin_index, end_index);
+	}
+
+	close(fds[1]);
+	if (pid < 0) {
+		close(fds[0]);
+		return;
+	}
+
+	child->pid = pid;
+	child->fd = fds[0];
+}
+
+void c_test_slot_add_failure(c_test_plan_t *plan, c_test_slot_t *slot, const c_test_definition_t *test_definition, 
+							 const char *format, ...) ATTRIBUTE_PRINT_FORMAT(4, 5);
+
+void c_test_slot_add_failure(c_test_plan_t *plan, c_test_slot_t *slot, const c_test_definition_t *test_definition, 
+							 const char *format, ...) {
+	c_test_message_t *message = (c_test_message_t*)c_test_arena_alloc(&plan->arena, sizeof(c_test_message_t));
+	message->is_failure = 1;
+	message->expression = "";
+	message->file_name = test_definition->file_name;
+	message->line_number = test_definition->line_number;
+
+	va_list args;
+	va_start(args, format);
+	message->text = c_test_arena_vprintf(&plan->arena, format, args);
+	va_end(args);
+
+	c_test_slot_append_message(slot, message);
+	slot->result.success = 0;
+	slot->done = 1;
+}
+
+void c_test_child_read_records(c_test_child_t *child, c_test_plan_t *plan, c_test_slot_t *slots) {
+	size_t offset = 0;
+	while (child->buffer_size - offset >= sizeof(c_test_record_header_t)) {
+		c_test_record_header_t header;
+		memcpy(&header, child->buffer + offset, sizeof(header));
+
+		const size_t payload_size = C_TEST_RECORD_END == header.type ? sizeof(c_test_result_t) : 
+			header.expression_size + header.file_name_size + header.text_size;
+		if (child->buffer_size - offset - sizeof(header) < payload_size) {
+			break;
+		}
+		const char *payload = child->buffer + offset + sizeof(header);
+		offset += sizeof(header) + payload_size;
+
+		c_test_slot_t *slot = slots + header.index;
+		if (C_TEST_RECORD_END == header.type) {
+			memcpy(&slot->result, payload, sizeof(c_test_result_t));
+			slot->done = 1;
+			child->next_index = header.index + 1;
+			child->test_start_ns = c_test_monotonic_ns();
+			continue;
+		}
+
+		char *text = (char*)c_test_arena_alloc(&plan->arena, payload_size + 3);
+		char *expression = text + header.text_size + 1;
+		char *file_name = expression + header.expression_size + 1;
+		memcpy(text, payload + header.expression_size + header.file_name_size, header.text_size);
+		text[header.text_size] = '\0';
+		memcpy(expression, payload, header.expression_size);
+		expression[header.expression_size] = '\0';
+		memcpy(file_name, payload + header.expression_size, header.file_name_size);
+		file_name[header.file_name_size] = '\0';
+
+		c_test_message_t *message = (c_test_message_t*)c_test_arena_alloc(&plan->arena, sizeof(c_test_message_t));
+		message->is_failure = C_TEST_RECORD_FAILURE == header.type;
+		message->expression = expression;
+		message->file_name = file_name;
+		message->line_number = header.value;
+		message->text = text;
+		c_test_slot_append_message(slot, message);
+	}
+
+	memmove(child->buffer, child->buffer + offset, child->buffer_size - offset);
+	child->buffer_size -= offset;
+}
+
+// Reaps the child and blames the test it was running, if any, for how it went away.
+void c_test_child_finish(c_test_child_t *child, c_test_plan_t *plan, c_test_slot_t *slots, int timed_out, 
+						 uint32_t timeout_ms) {
+	if (timed_out) {
+		kill(child->pid, SIGKILL);
+	}
+
+	int status = 0;
+	while (waitpid(child->pid, &status, 0) < 0 && EINTR == errno) {
+	}
+	close(child->fd);
+	child->pid = 0;
+	child->fd = -1;
+
+	if (child->next_index >= child->end_index) {
+		return;
+	}
+
+	const uint32_t index = child->next_index;
+	const c_test_definition_t *test_definition = plan->entries[index].definition;
+	slots[index].result.duration_ns = c_test_monotonic_ns() - child->test_start_ns;
+	if (timed_out) {
+		c_test_slot_add_failure(plan, slots + index, test_definition, "Test timed out after %u ms", timeout_ms);
+	} else if (WIFSIGNALED(status)) {
+		c_test_slot_add_failure(plan, slots + index, test_definition, "Test crashed with signal %d (%s)", 
+								WTERMSIG(status), strsignal(WTERMSIG(status)));
+	} else if (WIFEXITED(status)) {
+		c_test_slot_add_failure(plan, slots + index, test_definition, "Test exited with status %d", 
+								WEXITSTATUS(status));
+	} else {
+		c_test_slot_add_failure(plan, slots + index, test_definition, "Test process ended unexpectedly");
+	}
+	child->next_index = index + 1;
+}
+
+// Takes a child down without blaming anything on the test it was running.
+void c_test_child_kill(c_test_child_t *child) {
+	if (0 == child->pid) {
+		return;
+	}
+	kill(child->pid, SIGKILL);
+	while (waitpid(child->pid, NULL, 0) < 0 && EINTR == errno) {
+	}
+	close(child->fd);
+	child->pid = 0;
+	child->fd = -1;
+}
+
+uint32_t c_test_run_forked(c_test_runner_t *runner, c_test_plan_t *plan, uint32_t worker_count, uint32_t batch_size, 
+						   uint32_t timeout_ms) {
+	const uint32_t count = plan->count;
+	if (0 == batch_size) {
+		batch_size = 1;
+	}
+	if (worker_count > count) {
+		worker_count = count;
+	}
+	if (0 == worker_count) {
+		worker_count = 1;
+	}
+
+	c_test_slot_t *slots = (c_test_slot_t*)c_test_arena_calloc(&plan->arena, count, sizeof(c_test_slot_t));
+	c_test_child_t *children = (c_test_child_t*)calloc(worker_count, sizeof(c_test_child_t));
+	struct pollfd *poll_fds = (struct pollfd*)calloc(worker_count, sizeof(struct pollfd));
+	uint32_t *poll_children = (uint32_t*)calloc(worker_count, sizeof(uint32_t));
+	const uint64_t timeout_ns = timeout_ms * (uint64_t)1000000;
+
+	uint32_t next_batch_index = 0;
+	uint32_t replay_index = 0;
+	uint32_t failed_test_count = 0;
+
+	while (replay_index < count) {
+		uint32_t poll_count = 0;
+		for (uint32_t i = 0; i < worker_count; i++) {
+			c_test_child_t *child = children + i;
+			// Resume what is left of a batch before starting a new one.
+			while (0 == child->pid && child->next_index < child->end_index) {
+				c_test_child_spawn(child, plan, child->next_index, child->end_index);
+				if (0 == child->pid) {
+					const uint32_t index = child->next_index;
+					c_test_slot_add_failure(plan, slots + index, plan->entries[index].definition, 
+											"Unable to fork a test process");
+					child->next_index++;
+				}
+			}
+			if (0 == child->pid && next_batch_index < count) {
+				uint32_t end_index = next_batch_index + batch_size;
+				if (end_index > count) {
+					end_index = count;
+				}
+				// A failed spawn keeps the batch range and is retried as a resume on the next pass.
+				c_test_child_spawn(child, plan, next_batch_index, end_index);
+				next_batch_index = end_index;
+			}
+			if (0 != child->pid) {
+				poll_fds[poll_count].fd = child->fd;
+				poll_fds[poll_count].events = POLLIN;
+				poll_fds[poll_count].revents = 0;
+				poll_children[poll_count] = i;
+				poll_count++;
+			}
+		}
+
+		if (poll_count > 0) {
+			const uint64_t now_ns = c_test_monotonic_ns();
+			uint64_t wait_ns = UINT64_MAX;
+			if (0 != timeout_ms) {
+				for (uint32_t i = 0; i < poll_count; i++) {
+					const uint64_t elapsed_ns = now_ns - children[poll_children[i]].test_start_ns;
+					const uint64_t remaining_ns = elapsed_ns >= timeout_ns ? 0 : timeout_ns - elapsed_ns;
+					if (remaining_ns < wait_ns) {
+						wait_ns = remaining_ns;
+					}
+				}
+			}
+			if (0 != plan->deadline_ns) {
+				const uint64_t remaining_ns = now_ns >= plan->deadline_ns ? 0 : plan->deadline_ns - now_ns;
+				if (remaining_ns < wait_ns) {
+					wait_ns = remaining_ns;
+				}
+			}
+			const int poll_timeout_ms = UINT64_MAX == wait_ns ? -1 : (int)((wait_ns + 999999) / 1000000);
+
+			if (poll(poll_fds, poll_count, poll_timeout_ms) < 0 && EINTR != errno) {
+				// The children can no longer be watched, so take them down and fail every test that did not finish
+				// rather than letting the run pass without them.
+				const int poll_errno = errno;
+				for (uint32_t i = 0; i < worker_count; i++) {
+					c_test_child_kill(children + i);
+					children[i].next_index = children[i].end_index;
+				}
+				for (uint32_t i = replay_index; i < count; i++) {
+					if (!slots[i].done) {
+						c_test_slot_add_failure(plan, slots + i, plan->entries[i].definition, 
+												"Unable to poll the test processes: %s", strerror(poll_errno));
+					}
+				}
+				next_batch_index = count;
+				continue;
+			}
+
+			const uint64_t poll_end_ns = c_test_monotonic_ns();
+			for (uint32_t i = 0; i < poll_count; i++) {
+				c_test_child_t *child = children + poll_children[i];
+				if (0 != poll_fds[i].revents) {
+					if (child->buffer_capacity - child->buffer_size < 4096) {
+						child->buffer_capacity = 2 * child->buffer_capacity + 4096;
+						child->buffer = (char*)realloc(child->buffer, child->buffer_capacity);
+					}
+					ssize_t read_size = read(child->fd, child->buffer + child->buffer_size, 
+											 child->buffer_capacity - child->buffer_size);
+					if (read_size > 0) {
+						child->buffer_size += read_size;
+						c_test_child_read_records(child, plan, slots);
+					} else if (0 == read_size || EINTR != errno) {
+						c_test_child_finish(child, plan, slots, 0, timeout_ms);
+					}
+				} else if (0 != timeout_ms && poll_end_ns - child->test_start_ns >= timeout_ns) {
+					c_test_child_finish(child, plan, slots, 1, timeout_ms);
+				}
+			}
+		}
+
+		while (replay_index < count && slots[replay_index].done && 
+			   !c_test_plan_should_stop(plan, failed_test_count)) {
+			c_test_replay_slot(runner, plan->entries + replay_index, slots + replay_index);
+			plan->results[replay_index] = slots[replay_index].result;
+			if (!slots[replay_index].result.success) {
+				failed_test_count++;
+			}
+			replay_index++;
+		}
+
+		if (replay_index < count && c_test_plan_should_stop(plan, failed_test_count)) {
+			for (uint32_t i = 0; i < worker_count; i++) {
+				c_test_child_kill(children + i);
+			}
+			// Tests whose children finished before the stop keep their results; the others never completed.
+			for (; replay_index < count; replay_index++) {
+				if (slots[replay_index].done) {
+					c_test_replay_slot(runner, plan->entries + replay_index, slots + replay_index);
+					plan->results[replay_index] = slots[replay_index].result;
+					if (!slots[replay_index].result.success) {
+						failed_test_count++;
+					}
+				} else {
+					c_test_skip_entry(runner, plan->entries + replay_index, plan->results + replay_index);
+				}
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < worker_count; i++) {
+		free(children[i].buffer);
+	}
+	free(poll_children);
+	free(poll_fds);
+	free(children);
+	return failed_test_count;
+}
+
+#endif
+
+
+// === Running benchmarks === //
+
+int c_test_compare_doubles(const void *a, const void *b) {
+	const double lhs = *(const double*)a;
+	const double rhs = *(const double*)b;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+uint64_t c_test_time_benchmark(c_test_runner_t *runner, const c_test_definition_t *benchmark_definition, 
+							   uint64_t iterations) {
+	const uint64_t start_ns = c_test_monotonic_ns();
+	benchmark_definition->benchmark_function(runner, iterations);
+	return c_test_monotonic_ns() - start_ns;
+}
+
+// Grows the iteration count until a single run takes at least min_time_ns.
+uint64_t c_test_calibrate_benchmark(c_test_runner_t *runner, const c_test_definition_t *benchmark_definition, 
+									uint64_t min_time_ns) {
+	uint64_t iterations = 1;
+	for (;;) {
+		const uint64_t elapsed_ns = c_test_time_benchmark(runner, benchmark_definition, iterations);
+		if (elapsed_ns >= min_time_ns || iterations >= ((uint64_t)1 << 40)) {
+			return iterations;
+		}
+
+		// Overshoot the estimate a little so we usually land above the target on the next run, but never grow by 
+		// more than 10x since very short runs are mostly noise.
+		uint64_t next_iterations = elapsed_ns == 0 ? 10 * iterations : 
+			(uint64_t)(1.4 * (double)iterations * (double)min_time_ns / (double)elapsed_ns);
+		if (next_iterations > 10 * iterations) {
+			next_iterations = 10 * iterations;
+		}
+		if (next_iterations <= iterations) {
+			next_iterations = iterations + 1;
+		}
+		iterations = next_iterations;
+	}
+}
+
+int c_test_run_benchmark(c_test_runner_t *runner, const c_test_definition_t *benchmark_definition, 
+						 const c_test_options_t *options, c_test_arena_t *arena) {
+	runner->current_test = benchmark_definition;
+	const uint32_t start_error_count = runner->error_count;
+
+	const uint32_t repetitions = options->benchmark_repetitions == 0 ? 1 : options->benchmark_repetitions;
+	const uint64_t iterations = c_test_calibrate_benchmark(runner, benchmark_definition, 
+														   options->benchmark_min_time_ms * (uint64_t)1000000);
+
+	double *samples = (double*)c_test_arena_alloc(arena, sizeof(double) * repetitions);
+	double sum = 0;
+	for (uint32_t i = 0; i < repetitions; i++) {
+		samples[i] = (double)c_test_time_benchmark(runner, benchmark_definition, iterations) / (double)iterations;
+		sum += samples[i];
+	}
+	qsort(samples, repetitions, sizeof(double), c_test_compare_doubles);
+
+	c_test_benchmark_result_t result = {
+		.iterations = iterations,
+		.repetitions = repetitions,
+		.mean_ns = sum / repetitions,
+		.min_ns = samples[0],
+		.median_ns = repetitions % 2 == 1 ? samples[repetitions / 2] : 
+			(samples[repetitions / 2 - 1] + samples[repetitions / 2]) / 2,
+		.p99_ns = samples[(uint32_t)ceil(0.99 * repetitions) - 1],
+		.stddev_ns = 0,
+	};
+	double variance = 0;
+	for (uint32_t i = 0; i < repetitions; i++) {
+		variance += (samples[i] - result.mean_ns) * (samples[i] - result.mean_ns);
+	}
+	result.stddev_ns = repetitions > 1 ? sqrt(variance / (repetitions - 1)) : 0;
+
+	const int success = start_error_count == runner->error_count;
+	if (NULL != runner->benchmark_result) {
+		runner->benchmark_result(runner, &result, success);
+	}
+
+	runner->current_test = NULL;
+	return success;
+}
+
+uint32_t c_test_run_benchmarks(c_test_runner_t *runner, const c_test_definition_t *benchmark_definitions, 
+							   uint32_t count, const c_test_filter_t *filter, const c_test_options_t *options, 
+							   c_test_arena_t *arena) {
+	uint32_t failed_benchmark_count = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		if (!c_test_filter_matches(filter, benchmark_definitions + i, 0)) {
+			continue;
+		}
+		if (!c_test_run_benchmark(runner, benchmark_definitions + i, options, arena)) {
+			failed_benchmark_count++;
+		}
+	}
+	return failed_benchmark_count;
+}
+
+
+// === Fuzzing === //
+
+// Code compiled with -fsanitize-coverage=trace-pc-guard (Clang) or -fsanitize-coverage=trace-pc (GCC) calls the hooks
+// below on every edge or basic block, which count hits in a fixed size map. The hooks are only defined when built with
+// C_TEST_FUZZ, as they would otherwise take over the coverage runtime of any program linking the library. A fuzzed
+// input is interesting when it reaches a feature, a map slot with its hit count rounded to a power of two bucket, that
+// no earlier input reached, or when it is smaller than the smallest input reaching one of its features. The corpus
+// keeps only the inputs that are still the smallest for some feature.
+//
+// Each worker is a forked process running the target in a loop on inputs mutated from its corpus, which lives in
+// memory shared with the parent along with the input being run. When the target crashes, hangs or fails an assertion
+// the parent writes that input to a reproducer file, reports it through the runner and forks the worker again, which
+// carries on from the corpus the previous one left. A worker failing before it mutates anything fails on the empty
+// input, a seed or its own corpus, so it is not forked again, and a target stops being fuzzed after
+// kFuzzMaxFindings findings.
+
+#ifdef C_TEST_FUZZ
+
+// The hooks must not be instrumented themselves, even when the library is compiled with coverage.
+#if defined(__clang__)
+#define C_TEST_NO_COVERAGE __attribute__((no_sanitize("coverage")))
+#elif __GNUC__ >= 12
+#define C_TEST_NO_COVERAGE __attribute__((no_sanitize_coverage))
+#else
+#define C_TEST_NO_COVERAGE
+#endif
+
+#define C_TEST_COVERAGE_MAP_SIZE (1u << 16)
+
+static uint8_t c_test_coverage_map[C_TEST_COVERAGE_MAP_SIZE] __attribute__((aligned(64)));
+static uint32_t c_test_coverage_guard_count = 0;
+// Set while a hook runs on this thread, so an instrumented call made from within one is not counted.
+static __thread int c_test_in_coverage_hook __attribute__((tls_model("initial-exec")));
+
+C_TEST_NO_COVERAGE void __sanitizer_cov_trace_pc_guard_init(uint32_t *start, uint32_t *stop) {
+	if (start == stop || 0 != *start) {
+		return;
+	}
+	for (uint32_t *guard = start; guard < stop; guard++) {
+		*guard = ++c_test_coverage_guard_count;
+	}
+}
+
+C_TEST_NO_COVERAGE void __sanitizer_cov_trace_pc_guard(uint32_t *guard) {
+	if (c_test_in_coverage_hook) {
+		return;
+	}
+	c_test_in_coverage_hook = 1;
+	c_test_coverage_map[*guard & (C_TEST_COVERAGE_MAP_SIZE - 1)]++;
+	c_test_in_coverage_hook = 0;
+}
+
+C_TEST_NO_COVERAGE void __sanitizer_cov_trace_pc() {
+	if (c_test_in_coverage_hook) {
+		return;
+	}
+	c_test_in_coverage_hook = 1;
+	const uintptr_t pc = (uintptr_t)__builtin_return_address(0);
+	c_test_coverage_map[(pc ^ (pc >> 16)) & (C_TEST_COVERAGE_MAP_SIZE - 1)]++;
+	c_test_in_coverage_hook = 0;
+}
+
+#endif
+
+// Reads path into the input fuzz targets receive when they run as tests, returns 0 if it cannot be read.
+int c_test_load_fuzz_input(const char *path) {
+	FILE *file = fopen(path, "rb");
+	if (NULL == file) {
+		return 0;
+	}
+	c_test_vector_t data;
+	c_test_vector_init(&data, 1, 4096);
+	for (;;) {
+		const size_t read_size = fread((uint8_t*)data.data + data.count, 1, data.capacity - data.count, file);
+		data.count += read_size;
+		if (data.count < data.capacity) {
+			break;
+		}
+		c_test_vector_reserve(&data, 2 * data.capacity);
+	}
+	fclose(file);
+
+	c_test_fuzz_input_t *fuzz_input = c_test_get_fuzz_input();
+	fuzz_input->data = (uint8_t*)data.data;
+	fuzz_input->size = data.count;
+	return 1;
+}
+
+void c_test_release_fuzz_input() {
+	c_test_fuzz_input_t *fuzz_input = c_test_get_fuzz_input();
+	free(fuzz_input->data);
+	fuzz_input->data = NULL;
+	fuzz_input->size = 0;
+}
+
+#if defined(C_TEST_FUZZ) && defined(C_TEST_USE_FORK)
+
+#define C_TEST_FUZZ_CORPUS_CAPACITY 4096
+#define C_TEST_FUZZ_MESSAGE_SIZE 1024
+
+const uint16_t kNoFuzzEntry = UINT16_MAX;
+const int kFuzzFailureExitCode = 77;
+// Findings, repeated ones included, after which a target is no longer fuzzed.
+const uint32_t kFuzzMaxFindings = 100;
+// How long a worker may keep running its current input past the end of fuzzing, when no timeout is set.
+const uint64_t kFuzzGraceNs = 1000000000ULL;
+// Return addresses hashed into the site of a crash, out of at most C_TEST_FUZZ_MAX_STACK_DEPTH unwound.
+#define C_TEST_FUZZ_STACK_DEPTH 16
+#define C_TEST_FUZZ_MAX_STACK_DEPTH 256
+const int kFuzzCrashSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT, SIGTRAP};
+const uint8_t kInterestingBytes[] = {0, 1, 2, 16, 32, 64, 100, 127, 128, 200, 255};
+
+typedef struct {
+	// Read by the parent while the worker runs.
+	uint64_t execution_count;
+	uint64_t input_start_ns;
+	uint32_t feature_count;
+	// Set once the worker has run the empty input, the seeds or the corpus it inherited, and starts mutating.
+	int mutating;
+
+	// The input being run, and the assertion that failed on it when the worker exits with kFuzzFailureExitCode.
+	uint32_t input_size;
+	const char *expression;
+	const char *file_name;
+	int line_number;
+	char message[C_TEST_FUZZ_MESSAGE_SIZE];
+	// A hash of the stack the worker crashed or called exit on, 0 when it is not known.
+	uint64_t crash_site;
+
+	uint32_t corpus_count;
+	uint32_t corpus_sizes[C_TEST_FUZZ_CORPUS_CAPACITY];
+	// Followed by the input and then the corpus entries, fuzz_max_size bytes each.
+} c_test_fuzz_shared_t;
+
+size_t c_test_fuzz_shared_size(uint32_t max_size) {
+	const size_t page_size = 4096;
+	const size_t size = sizeof(c_test_fuzz_shared_t) + (size_t)max_size * (1 + C_TEST_FUZZ_CORPUS_CAPACITY);
+	return (size + page_size - 1) / page_size * page_size;
+}
+
+uint8_t* c_test_fuzz_shared_input(c_test_fuzz_shared_t *shared) {
+	return (uint8_t*)(shared + 1);
+}
+
+uint8_t* c_test_fuzz_entry(c_test_fuzz_shared_t *shared, uint32_t max_size, uint32_t index) {
+	return (uint8_t*)(shared + 1) + (size_t)max_size * (1 + index);
+}
+
+typedef struct {
+	c_test_runner_t runner;
+	const c_test_definition_t *definition;
+	c_test_fuzz_shared_t *shared;
+	uint8_t *input;
+	uint32_t max_size;
+	uint64_t random_state;
+
+	// A bit per hit count bucket of every map slot reached so far, the corpus entry holding the smallest input that
+	// reaches each feature, and the features the last input reached.
+	uint8_t *seen;
+	uint16_t *smallest;
+	uint32_t *hits;
+	uint32_t hit_count;
+	uint32_t feature_count;
+} c_test_fuzz_worker_t;
+
+void c_test_fuzz_message(c_test_runner_t *runner, const char *expression, const char *file_name, int line_number, 
+						 const char *format, va_list args) {
+	c_test_fuzz_worker_t *worker = runner->data;
+	if (0 == runner->error_count) {
+		worker->shared->expression = expression;
+		worker->shared->file_name = file_name;
+		worker->shared->line_number = line_number;
+		vsnprintf(worker->shared->message, C_TEST_FUZZ_MESSAGE_SIZE, format, args);
+	}
+	runner->error_count++;
+}
+
+void c_test_fuzz_failure(c_test_runner_t *runner, const char *expression, const char *file_name, int line_number, 
+						 const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	c_test_fuzz_message(runner, expression, file_name, line_number, format, args);
+	va_end(args);
+}
+
+void c_test_fuzz_success(c_test_runner_t *runner, const char *file_name, int line_number) {
+}
+
+void c_test_fuzz_passed(c_test_runner_t *runner, uint64_t passed_count) {
+}
+
+uint64_t c_test_hash_bytes(const uint8_t *data, size_t size) {
+	uint64_t hash = kHashSeed;
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ data[i]) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+static c_test_fuzz_shared_t *c_test_fuzz_crash_shared = NULL;
+// Frames on the stack up to the call of the target, which are left out of the site of a crash.
+static int c_test_fuzz_base_depth = 0;
+
+int c_test_fuzz_stack_depth(void) {
+#ifdef __GLIBC__
+	void *frames[C_TEST_FUZZ_MAX_STACK_DEPTH];
+	return backtrace(frames, C_TEST_FUZZ_MAX_STACK_DEPTH);
+#else
+	return 0;
+#endif
+}
+
+// Hashes the innermost frames above the call of the target, so findings of the same bug share a key whichever input
+// triggered it. Workers are forked from the same process, so the addresses are the same in all of them.
+uint64_t c_test_fuzz_stack_hash(void) {
+#ifdef __GLIBC__
+	void *frames[C_TEST_FUZZ_MAX_STACK_DEPTH];
+	const int frame_count = backtrace(frames, C_TEST_FUZZ_MAX_STACK_DEPTH);
+	int site_depth = frame_count < C_TEST_FUZZ_MAX_STACK_DEPTH ? frame_count - c_test_fuzz_base_depth : frame_count;
+	if (site_depth > C_TEST_FUZZ_STACK_DEPTH) {
+		site_depth = C_TEST_FUZZ_STACK_DEPTH;
+	}
+	return site_depth > 0 ? c_test_hash_bytes((const uint8_t*)frames, sizeof(void*) * site_depth) : 0;
+#else
+	return 0;
+#endif
+}
+
+void c_test_fuzz_crash_handler(int signal_number) {
+	c_test_fuzz_crash_shared->crash_site = c_test_fuzz_stack_hash();
+	// SA_RESETHAND restored the default action, which ends the worker once the handler returns.
+	raise(signal_number);
+}
+
+void c_test_fuzz_exit_handler(void) {
+	c_test_fuzz_crash_shared->crash_site = c_test_fuzz_stack_hash();
+}
+
+// Records the site of crashes and of calls to exit in the shared page. Handlers installed by the target or a sanitizer
+// are left alone, on an alternate stack so that stack overflows are recorded too.
+void c_test_fuzz_install_crash_handlers(c_test_fuzz_shared_t *shared) {
+	c_test_fuzz_crash_shared = shared;
+	atexit(c_test_fuzz_exit_handler);
+
+	stack_t stack = {
+		.ss_sp = malloc(1 << 16),
+		.ss_flags = 0,
+		.ss_size = 1 << 16,
+	};
+	sigaltstack(&stack, NULL);
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = c_test_fuzz_crash_handler;
+	action.sa_flags = SA_ONSTACK | SA_RESETHAND;
+	sigemptyset(&action.sa_mask);
+	for (size_t i = 0; i < sizeof(kFuzzCrashSignals) / sizeof(kFuzzCrashSignals[0]); i++) {
+		struct sigaction previous;
+		if (0 == sigaction(kFuzzCrashSignals[i], NULL, &previous) && SIG_DFL == previous.sa_handler) {
+			sigaction(kFuzzCrashSignals[i], &action, NULL);
+		}
+	}
+}
+
+// Runs the target on the shared input and returns when it started. A failed assertion ends the worker, leaving the
+// input for the parent to report.
+uint64_t c_test_fuzz_execute(c_test_fuzz_worker_t *worker) {
+	c_test_fuzz_shared_t *shared = worker->shared;
+	if (0 == c_test_fuzz_base_depth) {
+		// Also loads the unwinder, which cannot be done from a signal handler.
+		c_test_fuzz_base_depth = c_test_fuzz_stack_depth();
+	}
+	const uint64_t start_ns = c_test_monotonic_ns();
+	__atomic_store_n(&shared->input_start_ns, start_ns, __ATOMIC_RELAXED);
+	worker->definition->test_fuzz_function(&worker->runner, worker->input, shared->input_size);
+	if (0 != worker->runner.error_count) {
+		_exit(kFuzzFailureExitCode);
+	}
+	__atomic_store_n(&shared->execution_count, shared->execution_count + 1, __ATOMIC_RELAXED);
+	return start_ns;
+}
+
+uint32_t c_test_hit_bucket(uint8_t hits) {
+	if (hits < 4) {
+		return hits - 1;
+	}
+	return hits < 8 ? 3 : hits < 16 ? 4 : hits < 32 ? 5 : hits < 128 ? 6 : 7;
+}
+
+// Moves the coverage of the last execution out of the map into hits, returning how many of its features are new.
+uint32_t c_test_fuzz_collect(c_test_fuzz_worker_t *worker) {
+	uint32_t new_count = 0;
+	worker->hit_count = 0;
+	for (uint32_t i = 0; i < C_TEST_COVERAGE_MAP_SIZE; i += sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, c_test_coverage_map + i, sizeof(word));
+		if (0 == word) {
+			continue;
+		}
+		for (uint32_t slot = i; slot < i + sizeof(uint64_t); slot++) {
+			if (0 == c_test_coverage_map[slot]) {
+				continue;
+			}
+			const uint32_t bucket = c_test_hit_bucket(c_test_coverage_map[slot]);
+			worker->hits[worker->hit_count++] = slot * 8 + bucket;
+			if (0 == (worker->seen[slot] & (1u << bucket))) {
+				new_count++;
+			}
+		}
+		memset(c_test_coverage_map + i, 0, sizeof(word));
+	}
+	return new_count;
+}
+
+// Marks the features of the last execution as seen, and makes entry the smallest input for those it reaches with
+// fewer bytes, unless it is kNoFuzzEntry.
+void c_test_fuzz_record(c_test_fuzz_worker_t *worker, uint16_t entry) {
+	const uint32_t *sizes = worker->shared->corpus_sizes;
+	for (uint32_t i = 0; i < worker->hit_count; i++) {
+		const uint32_t feature = worker->hits[i];
+		const uint8_t bit = 1u << (feature % 8);
+		if (0 == (worker->seen[feature / 8] & bit)) {
+			worker->seen[feature / 8] |= bit;
+			worker->feature_count++;
+		}
+		const uint16_t smallest = worker->smallest[feature];
+		if (kNoFuzzEntry != entry && (kNoFuzzEntry == smallest || sizes[smallest] > sizes[entry])) {
+			worker->smallest[feature] = entry;
+		}
+	}
+	__atomic_store_n(&worker->shared->feature_count, worker->feature_count, __ATOMIC_RELAXED);
+}
+
+// Drops the entries that are no longer the smallest input for any feature.
+void c_test_fuzz_cull(c_test_fuzz_worker_t *worker) {
+	c_test_fuzz_shared_t *shared = worker->shared;
+	uint16_t *remap = (uint16_t*)malloc(sizeof(uint16_t) * C_TEST_FUZZ_CORPUS_CAPACITY);
+	memset(remap, 0xff, sizeof(uint16_t) * C_TEST_FUZZ_CORPUS_CAPACITY);
+	for (uint32_t feature = 0; feature < C_TEST_COVERAGE_MAP_SIZE * 8; feature++) {
+		if (kNoFuzzEntry != worker->smallest[feature]) {
+			remap[worker->smallest[feature]] = 0;
+		}
+	}
+
+	uint32_t kept_count = 0;
+	for (uint32_t i = 0; i < shared->corpus_count; i++) {
+		if (kNoFuzzEntry == remap[i]) {
+			continue;
+		}
+		remap[i] = kept_count;
+		if (kept_count != i) {
+			memcpy(c_test_fuzz_entry(shared, worker->max_size, kept_count), 
+				   c_test_fuzz_entry(shared, worker->max_size, i), shared->corpus_sizes[i]);
+			shared->corpus_sizes[kept_count] = shared->corpus_sizes[i];
+		}
+		kept_count++;
+	}
+	shared->corpus_count = kept_count;
+
+	for (uint32_t feature = 0; feature < C_TEST_COVERAGE_MAP_SIZE * 8; feature++) {
+		if (kNoFuzzEntry != worker->smallest[feature]) {
+			worker->smallest[feature] = remap[worker->smallest[feature]];
+		}
+	}
+	free(remap);
+}
+
+// Adds the input just run to the corpus when it reached a new feature or reaches one with fewer bytes than the
+// smallest input so far.
+void c_test_fuzz_consider(c_test_fuzz_worker_t *worker, uint32_t new_count) {
+	c_test_fuzz_shared_t *shared = worker->shared;
+	int interesting = new_count > 0 || 0 == shared->corpus_count;
+	for (uint32_t i = 0; i < worker->hit_count && !interesting; i++) {
+		const uint16_t smallest = worker->smallest[worker->hits[i]];
+		interesting = kNoFuzzEntry != smallest && shared->corpus_sizes[smallest] > shared->input_size;
+	}
+	if (!interesting) {
+		return;
+	}
+
+	if (C_TEST_FUZZ_CORPUS_CAPACITY == shared->corpus_count) {
+		c_test_fuzz_cull(worker);
+	}
+	if (C_TEST_FUZZ_CORPUS_CAPACITY == shared->corpus_count) {
+		c_test_fuzz_record(worker, kNoFuzzEntry);
+		return;
+	}
+	const uint16_t entry = shared->corpus_count;
+	memcpy(c_test_fuzz_entry(shared, worker->max_size, entry), worker->input, shared->input_size);
+	shared->corpus_sizes[entry] = shared->input_size;
+	shared->corpus_count++;
+	c_test_fuzz_record(worker, entry);
+}
+
+// Replaces the shared input with a random corpus entry changed by a few random mutations.
+void c_test_fuzz_mutate(c_test_fuzz_worker_t *worker) {
+	c_test_fuzz_shared_t *shared = worker->shared;
+	uint8_t *input = worker->input;
+	const uint32_t max_size = worker->max_size;
+
+	const uint32_t base = c_test_next_random(&worker->random_state) % shared->corpus_count;
+	uint32_t size = shared->corpus_sizes[base];
+	memcpy(input, c_test_fuzz_entry(shared, max_size, base), size);
+
+	const uint32_t mutation_count = 1u << (c_test_next_random(&worker->random_state) % 4);
+	for (uint32_t i = 0; i < mutation_count; i++) {
+		const uint64_t random = c_test_next_random(&worker->random_state);
+		const uint32_t choice = random % 8;
+		const uint32_t position = 0 == size ? 0 : (random >> 8) % size;
+		const uint32_t value = random >> 40;
+		switch (choice) {
+		case 0:
+			if (size > 0) {
+				input[position] ^= 1u << (value % 8);
+			}
+			break;
+		case 1:
+			if (size > 0) {
+				input[position] = value;
+			}
+			break;
+		case 2:
+			if (size > 0) {
+				input[position] = kInterestingBytes[value % sizeof(kInterestingBytes)];
+			}
+			break;
+		case 3:
+			if (size > 0) {
+				input[position] += value % 33 - 16;
+			}
+			break;
+		case 4: {
+			// Inserts up to 8 random bytes.
+			const uint32_t insert_size = size >= max_size ? 0 : 1 + value % (max_size - size < 8 ? max_size - size : 8);
+			const uint32_t at = 0 == size ? 0 : (random >> 8) % (size + 1);
+			memmove(input + at + insert_size, input + at, size - at);
+			for (uint32_t j = 0; j < insert_size; j++) {
+				input[at + j] = c_test_next_random(&worker->random_state);
+			}
+			size += insert_size;
+			break;
+		}
+		case 5: {
+			// Erases up to 8 bytes.
+			if (0 == size) {
+				break;
+			}
+			const uint32_t erase_size = 1 + value % (size < 8 ? size : 8);
+			const uint32_t at = (random >> 8) % (size - erase_size + 1);
+			memmove(input + at, input + at + erase_size, size - at - erase_size);
+			size -= erase_size;
+			break;
+		}
+		case 6: {
+			// Copies a chunk of the input over another part of it.
+			if (size < 2) {
+				break;
+			}
+			const uint32_t chunk_size = 1 + value % (size / 2);
+			const uint32_t from = (random >> 8) % (size - chunk_size + 1);
+			const uint32_t to = (value >> 8) % (size - chunk_size + 1);
+			memmove(input + to, input + from, chunk_size);
+			break;
+		}
+		default: {
+			// Splices the tail of another entry after a prefix of this one.
+			const uint32_t other = value % shared->corpus_count;
+			const uint32_t other_size = shared->corpus_sizes[other];
+			if (0 == other_size) {
+				break;
+			}
+			const uint32_t at = 0 == size ? 0 : (random >> 8) % (size + 1);
+			const uint32_t from = (random >> 24) % other_size;
+			const uint32_t copy_size = other_size - from < max_size - at ? other_size - from : max_size - at;
+			memcpy(input + at, c_test_fuzz_entry(shared, max_size, other) + from, copy_size);
+			size = at + copy_size;
+			break;
+		}
+		}
+	}
+	shared->input_size = size;
+}
+
+void c_test_fuzz_load_seeds(c_test_fuzz_worker_t *worker, const char *corpus_path) {
+	DIR *directory = opendir(corpus_path);
+	if (NULL == directory) {
+		return;
+	}
+	char path[4096];
+	struct dirent *directory_entry;
+	while (NULL != (directory_entry = readdir(directory))) {
+		if ('.' == directory_entry->d_name[0]) {
+			continue;
+		}
+		snprintf(path, sizeof(path), "%s/%s", corpus_path, directory_entry->d_name);
+		FILE *file = fopen(path, "rb");
+		if (NULL == file) {
+			continue;
+		}
+		worker->shared->input_size = fread(worker->input, 1, worker->max_size, file);
+		fclose(file);
+		c_test_fuzz_execute(worker);
+		c_test_fuzz_consider(worker, c_test_fuzz_collect(worker));
+	}
+	closedir(directory);
+}
+
+void c_test_fuzz_worker_main(const c_test_definition_t *definition, const c_test_options_t *options, 
+							 c_test_fuzz_shared_t *shared, uint64_t seed, uint64_t deadline_ns) {
+	// An inherited counter group would keep counting the parent's thread.
+	c_test_counters_release();
+	c_test_fuzz_worker_t worker = {
+		.runner = {
+			.failure = c_test_fuzz_failure,
+			.success = c_test_fuzz_success,
+			.passed = c_test_fuzz_passed,
+			.error = c_test_fuzz_failure,
+
+			.begin_test = NULL,
+			.end_test = NULL,
+			.skip_test = NULL,
+
+			.begin_tests = NULL,
+			.end_tests = NULL,
+
+			.benchmark_result = NULL,
+
+			.destroy = NULL,
+
+			.error_count = 0,
+			.data = &worker,
+			.current_test = definition,
+			.current_case = 0,
+			.current_result = NULL,
+		},
+		.definition = definition,
+		.shared = shared,
+		.input = c_test_fuzz_shared_input(shared),
+		.max_size = options->fuzz_max_size,
+		.random_state = seed,
+
+		.seen = (uint8_t*)calloc(C_TEST_COVERAGE_MAP_SIZE, 1),
+		.smallest = (uint16_t*)malloc(sizeof(uint16_t) * C_TEST_COVERAGE_MAP_SIZE * 8),
+		.hits = (uint32_t*)malloc(sizeof(uint32_t) * C_TEST_COVERAGE_MAP_SIZE),
+		.hit_count = 0,
+		.feature_count = 0,
+	};
+	memset(worker.smallest, 0xff, sizeof(uint16_t) * C_TEST_COVERAGE_MAP_SIZE * 8);
+	memset(c_test_coverage_map, 0, sizeof(c_test_coverage_map));
+	c_test_fuzz_install_crash_handlers(shared);
+
+	if (0 == shared->corpus_count) {
+		shared->input_size = 0;
+		c_test_fuzz_execute(&worker);
+		c_test_fuzz_consider(&worker, c_test_fuzz_collect(&worker));
+		if (NULL != options->fuzz_corpus_path) {
+			c_test_fuzz_load_seeds(&worker, options->fuzz_corpus_path);
+		}
+	} else {
+		// The previous worker died on an input, rebuild the coverage of the corpus it left behind.
+		for (uint32_t i = 0; i < shared->corpus_count; i++) {
+			shared->input_size = shared->corpus_sizes[i];
+			memcpy(worker.input, c_test_fuzz_entry(shared, worker.max_size, i), shared->input_size);
+			c_test_fuzz_execute(&worker);
+			c_test_fuzz_collect(&worker);
+			c_test_fuzz_record(&worker, i);
+		}
+	}
+
+	shared->mutating = 1;
+	uint64_t start_ns = 0;
+	while (start_ns < deadline_ns) {
+		c_test_fuzz_mutate(&worker);
+		start_ns = c_test_fuzz_execute(&worker);
+		c_test_fuzz_consider(&worker, c_test_fuzz_collect(&worker));
+	}
+	c_test_fuzz_cull(&worker);
+	_exit(0);
+}
+
+typedef struct {
+	pid_t pid;
+	c_test_fuzz_shared_t *shared;
+} c_test_fuzz_process_t;
+
+typedef struct {
+	c_test_runner_t *runner;
+	const c_test_definition_t *definition;
+	const c_test_options_t *options;
+	uint64_t deadline_ns;
+	uint64_t random_state;
+	// Keys of the findings reported so far, so a bug hit over and over is reported once.
+	c_test_vector_t finding_keys;
+	uint32_t finding_count;
+	// Why workers stopped being forked again before the deadline, NULL while they are.
+	const char *stop_reason;
+} c_test_fuzz_session_t;
+
+int c_test_fuzz_spawn(c_test_fuzz_session_t *session, c_test_fuzz_process_t *process) {
+	process->shared->input_size = 0;
+	process->shared->input_start_ns = 0;
+	process->shared->mutating = 0;
+	process->shared->crash_site = 0;
+	const uint64_t seed = c_test_next_random(&session->random_state);
+	fflush(stdout);
+	fflush(stderr);
+	process->pid = fork();
+	if (0 == process->pid) {
+		c_test_fuzz_worker_main(session->definition, session->options, process->shared, seed, session->deadline_ns);
+	}
+	if (process->pid < 0) {
+		process->pid = 0;
+		return 0;
+	}
+	return 1;
+}
+
+int c_test_write_file(const char *path, const uint8_t *data, size_t size) {
+	char temporary_path[4096];
+	FILE *file = c_test_open_temporary(path, "wb", temporary_path, sizeof(temporary_path));
+	if (NULL == file) {
+		return 0;
+	}
+	fwrite(data, 1, size, file);
+	return c_test_replace_file(file, temporary_path, path);
+}
+
+// Writes the input a worker was running to "<artifact path>/<kind>-<namespace>.<test>-<hash>" and reports it, unless
+// a finding with the same key was reported before.
+void c_test_fuzz_report(c_test_fuzz_session_t *session, c_test_fuzz_shared_t *shared, uint64_t key, const char *kind, 
+						const char *expression, const char *file_name, int line_number, const char *description) {
+	session->finding_count++;
+	const uint64_t *keys = (const uint64_t*)session->finding_keys.data;
+	for (uint32_t i = 0; i < session->finding_keys.count; i++) {
+		if (keys[i] == key) {
+			return;
+		}
+	}
+	c_test_vector_push_back(&session->finding_keys, &key);
+
+	const uint8_t *input = c_test_fuzz_shared_input(shared);
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/%s-%s.%s-%016llx", 
+			 NULL == session->options->fuzz_artifact_path ? "." : session->options->fuzz_artifact_path, kind, 
+			 session->definition->name_space, session->definition->test_name, 
+			 (unsigned long long)c_test_hash_bytes(input, shared->input_size));
+	if (c_test_write_file(path, input, shared->input_size)) {
+		session->runner->failure(session->runner, expression, file_name, line_number, "Input %s (%u bytes): %s", path, 
+								 shared->input_size, description);
+	} else {
+		session->runner->failure(session->runner, expression, file_name, line_number, 
+								 "Input of %u bytes, not written to %s: %s", shared->input_size, path, description);
+	}
+}
+
+// Reports how a worker ended, returns non-zero if it found something.
+int c_test_fuzz_reap(c_test_fuzz_session_t *session, c_test_fuzz_shared_t *shared, int status) {
+	const c_test_definition_t *definition = session->definition;
+	char description[256];
+	if (WIFEXITED(status) && 0 == WEXITSTATUS(status)) {
+		return 0;
+	} else if (WIFEXITED(status) && kFuzzFailureExitCode == WEXITSTATUS(status)) {
+		const uint64_t key = c_test_hash_string(kHashSeed, shared->file_name) ^ (uint64_t)shared->line_number;
+		c_test_fuzz_report(session, shared, key, "failure", shared->expression, shared->file_name, 
+						   shared->line_number, shared->message);
+		return 1;
+	}
+
+	// Crashes are told apart by where they happened, and only by how the worker ended when that is not known.
+	const uint64_t how = WIFSIGNALED(status) ? (uint64_t)WTERMSIG(status) : 256 + (uint64_t)WEXITSTATUS(status);
+	const uint64_t key = 0 == shared->crash_site ? how : (shared->crash_site ^ how) * 1099511628211ULL;
+	if (WIFSIGNALED(status)) {
+		snprintf(description, sizeof(description), "crashed with signal %d (%s)", WTERMSIG(status), 
+				 strsignal(WTERMSIG(status)));
+	} else {
+		snprintf(description, sizeof(description), "exited with status %d", WEXITSTATUS(status));
+	}
+	c_test_fuzz_report(session, shared, key, "crash", "", definition->file_name, definition->line_number, description);
+	return 1;
+}
+
+// Waits for every worker to reach the deadline, forking a new one in place of each that crashed, hung or failed.
+void c_test_fuzz_supervise(c_test_fuzz_session_t *session, c_test_fuzz_process_t *processes, uint32_t count) {
+	const uint64_t timeout_ns = session->options->timeout_ms * 1000000ULL;
+	uint32_t running_count = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		running_count += c_test_fuzz_spawn(session, processes + i);
+	}
+
+	while (running_count > 0) {
+		poll(NULL, 0, 10);
+		const uint64_t now_ns = c_test_monotonic_ns();
+		for (uint32_t i = 0; i < count; i++) {
+			c_test_fuzz_process_t *process = processes + i;
+			if (0 == process->pid) {
+				continue;
+			}
+
+			int status = 0;
+			const pid_t result = waitpid(process->pid, &status, WNOHANG);
+			if (result < 0 && EINTR == errno) {
+				continue;
+			}
+			int found = 0;
+			if (0 == result) {
+				// Without a timeout only inputs still running well after the deadline count as hangs.
+				const uint64_t input_start_ns = __atomic_load_n(&process->shared->input_start_ns, __ATOMIC_RELAXED);
+				const int hung = 0 != input_start_ns && (0 != timeout_ns ? now_ns > input_start_ns + timeout_ns : 
+														 now_ns > session->deadline_ns + kFuzzGraceNs && 
+														 input_start_ns < session->deadline_ns);
+				if (!hung && now_ns < session->deadline_ns + kFuzzGraceNs) {
+					continue;
+				}
+				kill(process->pid, SIGKILL);
+				waitpid(process->pid, NULL, 0);
+				if (hung) {
+					char description[64];
+					snprintf(description, sizeof(description), "timed out after %llu ms", 
+							 (unsigned long long)(now_ns - input_start_ns) / 1000000);
+					c_test_fuzz_report(session, process->shared, 0, "timeout", "", session->definition->file_name, 
+									   session->definition->line_number, description);
+					found = 1;
+				}
+			} else if (result > 0) {
+				found = c_test_fuzz_reap(session, process->shared, status);
+			}
+
+			if (found && !process->shared->mutating) {
+				session->stop_reason = "the target fails before any input is mutated";
+			} else if (found && session->finding_count >= kFuzzMaxFindings) {
+				session->stop_reason = "the target reached the limit of findings";
+			}
+			if (!found || NULL != session->stop_reason || now_ns >= session->deadline_ns || 
+				!c_test_fuzz_spawn(session, process)) {
+				process->pid = 0;
+				running_count--;
+			}
+		}
+	}
+}
+
+void c_test_fuzz_save_corpus(const char *corpus_path, const c_test_fuzz_process_t *processes, uint32_t count, 
+							 uint32_t max_size) {
+	mkdir(corpus_path, 0777);
+	char path[4096];
+	for (uint32_t i = 0; i < count; i++) {
+		c_test_fuzz_shared_t *shared = processes[i].shared;
+		for (uint32_t j = 0; j < shared->corpus_count; j++) {
+			const uint8_t *entry = c_test_fuzz_entry(shared, max_size, j);
+			snprintf(path, sizeof(path), "%s/%016llx", corpus_path, 
+					 (unsigned long long)c_test_hash_bytes(entry, shared->corpus_sizes[j]));
+			c_test_write_file(path, entry, shared->corpus_sizes[j]);
+		}
+	}
+}
+
+int c_test_fuzz_target(c_test_runner_t *runner, const c_test_definition_t *definition, 
+					   const c_test_options_t *options, uint32_t worker_count) {
+	runner->current_test = definition;
+	runner->current_case = 0;
+	const uint32_t start_error_count = runner->error_count;
+	if (NULL != runner->begin_test) {
+		runner->begin_test(runner);
+	}
+
+	const uint64_t start_ns = c_test_monotonic_ns();
+	const size_t shared_size = c_test_fuzz_shared_size(options->fuzz_max_size);
+	uint8_t *shared_memory = (uint8_t*)mmap(NULL, shared_size * worker_count, PROT_READ | PROT_WRITE, 
+										   MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (MAP_FAILED == shared_memory) {
+		runner->failure(runner, "", definition->file_name, definition->line_number, 
+						"Could not map %llu bytes for the fuzzing corpus", 
+						(unsigned long long)(shared_size * worker_count));
+	} else {
+		c_test_fuzz_session_t session = {
+			.runner = runner,
+			.definition = definition,
+			.options = options,
+			.deadline_ns = start_ns + options->fuzz_time_ms * 1000000ULL,
+			.random_state = c_test_choose_shuffle_seed(),
+			.finding_count = 0,
+			.stop_reason = NULL,
+		};
+		c_test_vector_init(&session.finding_keys, sizeof(uint64_t), kDefaultVectorCapacity);
+		c_test_fuzz_process_t *processes = (c_test_fuzz_process_t*)malloc(sizeof(c_test_fuzz_process_t) * worker_count);
+		for (uint32_t i = 0; i < worker_count; i++) {
+			processes[i].pid = 0;
+			processes[i].shared = (c_test_fuzz_shared_t*)(shared_memory + shared_size * i);
+		}
+
+		c_test_fuzz_supervise(&session, processes, worker_count);
+		if (NULL != session.stop_reason) {
+			runner->failure(runner, "", definition->file_name, definition->line_number, 
+							"Stopped fuzzing after %u findings, %s", session.finding_count, session.stop_reason);
+		}
+
+		uint64_t execution_count = 0;
+		uint32_t corpus_count = 0;
+		uint32_t feature_count = 0;
+		for (uint32_t i = 0; i < worker_count; i++) {
+			execution_count += processes[i].shared->execution_count;
+			corpus_count += processes[i].shared->corpus_count;
+			if (processes[i].shared->feature_count > feature_count) {
+				feature_count = processes[i].shared->feature_count;
+			}
+		}
+		if (NULL != options->fuzz_corpus_path) {
+			c_test_fuzz_save_corpus(options->fuzz_corpus_path, processes, worker_count, options->fuzz_max_size);
+		}
+
+		const double seconds = (c_test_monotonic_ns() - start_ns) / 1e9;
+		fflush(stdout);
+		fprintf(stderr, 
+				"[   FUZZ   ] %s.%s %llu runs (%.0f/s) on %u workers, %u corpus inputs, %u features, %u findings\n", 
+				definition->name_space, definition->test_name, (unsigned long long)execution_count, 
+				execution_count / seconds, worker_count, corpus_count, feature_count, session.finding_count);
+		if (0 == feature_count && execution_count > 0) {
+			fprintf(stderr, "c_test: %s.%s reached no coverage, compile it with -fsanitize-coverage=trace-pc-guard "
+					"(Clang) or -fsanitize-coverage=trace-pc (GCC)\n", definition->name_space, definition->test_name);
+		}
+
+		free(processes);
+		c_test_vector_destroy(&session.finding_keys);
+		munmap(shared_memory, shared_size * worker_count);
+	}
+
+	c_test_result_t result;
+	memset(&result, 0, sizeof(result));
+	result.success = start_error_count == runner->error_count;
+	result.duration_ns = c_test_monotonic_ns() - start_ns;
+	if (NULL != runner->end_test) {
+		runner->current_result = &result;
+		runner->end_test(runner, result.success);
+		runner->current_result = NULL;
+	}
+	runner->current_test = NULL;
+	return result.success;
+}
+
+// Fuzzes the fuzz targets among the planned tests one after another, each on worker_count processes.
+uint32_t c_test_run_fuzz_tests(c_test_runner_t *runner, const c_test_plan_t *plan, const c_test_options_t *options, 
+							   uint32_t worker_count) {
+	uint32_t target_count = 0;
+	for (uint32_t i = 0; i < plan->count; i++) {
+		target_count += NULL != plan->entries[i].definition->test_fuzz_function;
+	}
+	if (NULL != runner->begin_tests) {
+		runner->begin_tests(runner, target_count);
+	}
+	uint32_t failed_count = 0;
+	for (uint32_t i = 0; i < plan->count; i++) {
+		const c_test_definition_t *definition = plan->entries[i].definition;
+		if (NULL != definition->test_fuzz_function && !c_test_fuzz_target(runner, definition, options, worker_count)) {
+			failed_count++;
+		}
+	}
+	if (NULL != runner->end_tests) {
+		runner->end_tests(runner, target_count, failed_count);
+	}
+	return failed_count;
+}
+
+#else
+
+uint32_t c_test_run_fuzz_tests(c_test_runner_t *runner, const c_test_plan_t *plan, const c_test_options_t *options, 
+							   uint32_t worker_count) {
+	fprintf(stderr, "c_test: fuzzing requires building with C_TEST_FUZZ and C_TEST_USE_FORK\n");
+	return 1;
+}
+
+#endif
+
+
+// === Performance baselines === //
+
+// Baseline files hold one "<namespace>.<test>[/<case>].<name> <median_ns> <mad_ns>" line per timed block. Recording
+// appends a line per block, so tests on worker threads and in child processes can record without coordinating. The
+// last line for a name wins, and the file is compacted when a recording run starts.
+
+const char *kDefaultBaselinePath = ".c_test_baselines";
+// Each sample runs the block for at least this long.
+const uint64_t kPerfMinBatchNs = 100000;
+// How far above the baseline median, in baseline MADs, a median may be before tolerance is applied on top.
+const double kPerfAllowedMads = 3.0;
+
+typedef struct {
+	uint64_t name_hash;
+	uint32_t order;
+	double median_ns;
+	double mad_ns;
+} c_test_baseline_t;
+
+typedef struct {
+	const char *path;
+	int record;
+	c_test_vector_t baselines;
+} c_test_baseline_file_t;
+
+// Set up for the duration of a run, read only while tests run.
+c_test_baseline_file_t* c_test_get_baseline_file() {
+	static c_test_baseline_file_t baseline_file = {.path = NULL, .record = 0};
+	return &baseline_file;
+}
+
+int c_test_compare_baselines_by_name(const void *a, const void *b) {
+	const uint64_t lhs = ((const c_test_baseline_t*)a)->name_hash;
+	const uint64_t rhs = ((const c_test_baseline_t*)b)->name_hash;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+int c_test_compare_baselines(const void *a, const void *b) {
+	const c_test_baseline_t *lhs = a;
+	const c_test_baseline_t *rhs = b;
+	if (lhs->name_hash != rhs->name_hash) {
+		return lhs->name_hash < rhs->name_hash ? -1 : 1;
+	}
+	return (lhs->order > rhs->order) - (lhs->order < rhs->order);
+}
+
+// Loads every baseline of path sorted by name hash, keeping only the last line of each name. Lines are copied into
+// arena and written to lines when it is not NULL, in file order.
+void c_test_read_baselines(const char *path, c_test_vector_t *baselines, c_test_vector_t *lines, 
+						   c_test_arena_t *arena) {
+	c_test_vector_init(baselines, sizeof(c_test_baseline_t), kDefaultVectorCapacity);
+	FILE *file = fopen(path, "r");
+	if (NULL == file) {
+		return;
+	}
+
+	char line[1024];
+	while (NULL != fgets(line, sizeof(line), file)) {
+		char *name_end = strchr(line, ' ');
+		if (NULL == name_end) {
+			continue;
+		}
+		*name_end = '\0';
+		c_test_baseline_t baseline = {
+			.name_hash = c_test_hash_string(kHashSeed, line),
+			.order = baselines->count,
+			.median_ns = 0,
+			.mad_ns = 0,
+		};
+		if (2 != sscanf(name_end + 1, "%lf %lf", &baseline.median_ns, &baseline.mad_ns)) {
+			continue;
+		}
+		c_test_vector_push_back(baselines, &baseline);
+		if (NULL != lines) {
+			*name_end = ' ';
+			char *text = c_test_arena_printf(arena, "%s", line);
+			c_test_vector_push_back(lines, &text);
+		}
+	}
+	fclose(file);
+
+	qsort(baselines->data, baselines->count, sizeof(c_test_baseline_t), c_test_compare_baselines);
+	c_test_baseline_t *data = (c_test_baseline_t*)baselines->data;
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < baselines->count; i++) {
+		if (i + 1 < baselines->count && data[i + 1].name_hash == data[i].name_hash) {
+			continue;
+		}
+		data[count++] = data[i];
+	}
+	baselines->count = count;
+}
+
+// Rewrites the file with only the lines still in effect.
+void c_test_compact_baselines(const char *path) {
+	c_test_vector_t baselines;
+	c_test_vector_t lines;
+	c_test_vector_init(&lines, sizeof(char*), kDefaultVectorCapacity);
+	c_test_arena_t arena;
+	c_test_arena_init(&arena, kDefaultArenaBlockSize);
+	c_test_read_baselines(path, &baselines, &lines, &arena);
+
+	char **texts = (char**)lines.data;
+	if (lines.count > baselines.count) {
+		// Mark what survived, then write it back in file order.
+		char *kept = (char*)c_test_arena_calloc(&arena, lines.count, 1);
+		const c_test_baseline_t *data = (const c_test_baseline_t*)baselines.data;
+		for (uint32_t i = 0; i < baselines.count; i++) {
+			kept[data[i].order] = 1;
+		}
+		char temporary_path[4096];
+		FILE *file = c_test_open_temporary(path, "w", temporary_path, sizeof(temporary_path));
+		if (NULL != file) {
+			for (uint32_t i = 0; i < lines.count; i++) {
+				if (kept[i]) {
+					fputs(texts[i], file);
+				}
+			}
+			c_test_replace_file(file, temporary_path, path);
+		}
+	}
+
+	c_test_arena_destroy(&arena);
+	c_test_vector_destroy(&lines);
+	c_test_vector_destroy(&baselines);
+}
+
+void c_test_open_baselines(const c_test_options_t *options) {
+	c_test_baseline_file_t *baseline_file = c_test_get_baseline_file();
+	baseline_file->path = NULL == options->baseline_path ? kDefaultBaselinePath : options->baseline_path;
+	baseline_file->record = options->record_baseline;
+	if (baseline_file->record) {
+		c_test_compact_baselines(baseline_file->path);
+		c_test_vector_init(&baseline_file->baselines, sizeof(c_test_baseline_t), 1);
+	} else {
+		c_test_read_baselines(baseline_file->path, &baseline_file->baselines, NULL, NULL);
+	}
+}
+
+void c_test_close_baselines() {
+	c_test_baseline_file_t *baseline_file = c_test_get_baseline_file();
+	if (NULL != baseline_file->path) {
+		c_test_vector_destroy(&baseline_file->baselines);
+		baseline_file->path = NULL;
+	}
+}
+
+c_test_perf_t c_test_perf_begin(c_test_runner_t *runner, const char *name, const char *expression, double tolerance, 
+								const char *file_name, int line_number) {
+	c_test_perf_t perf = {
+		.runner = runner,
+		.name = name,
+		.expression = expression,
+		.tolerance = tolerance,
+		.file_name = file_name,
+		.line_number = line_number,
+
+		.batch_size = 1,
+		.batch_iteration = 0,
+		.batch_start_ns = c_test_monotonic_ns(),
+		.calibrating = 1,
+		.sample_count = 0,
+	};
+	return perf;
+}
+
+double c_test_median(double *values, uint32_t count) {
+	qsort(values, count, sizeof(double), c_test_compare_doubles);
+	return count % 2 == 1 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2;
+}
+
+void c_test_perf_finish(c_test_perf_t *perf) {
+	c_test_runner_t *runner = perf->runner;
+	double deviations[C_TEST_PERF_SAMPLE_COUNT];
+	const double median_ns = c_test_median(perf->samples_ns, perf->sample_count);
+	for (uint32_t i = 0; i < perf->sample_count; i++) {
+		deviations[i] = fabs(perf->samples_ns[i] - median_ns);
+	}
+	const double mad_ns = c_test_median(deviations, perf->sample_count);
+
+	const c_test_baseline_file_t *baseline_file = c_test_get_baseline_file();
+	if (NULL == baseline_file->path || NULL == runner->current_test) {
+		return;
+	}
+
+	char suffix[C_TEST_CASE_SUFFIX_SIZE];
+	char name[1024];
+	snprintf(name, sizeof(name), "%s.%s%s.%s", runner->current_test->name_space, runner->current_test->test_name, 
+			 c_test_case_suffix(runner->current_test, runner->current_case, suffix, sizeof(suffix)), perf->name);
+
+	if (baseline_file->record) {
+		const int tracking = c_test_suspend_allocation_tracking();
+		FILE *file = fopen(baseline_file->path, "a");
+		if (NULL != file) {
+			fprintf(file, "%s %.3f %.3f\n", name, median_ns, mad_ns);
+			fclose(file);
+		}
+		c_test_resume_allocation_tracking(tracking);
+		return;
+	}
+
+	const c_test_baseline_t key = {
+		.name_hash = c_test_hash_string(kHashSeed, name),
+	};
+	const c_test_baseline_t *baseline = bsearch(&key, baseline_file->baselines.data, baseline_file->baselines.count, 
+												sizeof(c_test_baseline_t), c_test_compare_baselines_by_name);
+	if (NULL == baseline) {
+		return;
+	}
+	const double allowed_ns = (baseline->median_ns + kPerfAllowedMads * baseline->mad_ns) * (1.0 + perf->tolerance);
+	if (median_ns > allowed_ns) {
+		runner->error(runner, perf->expression, perf->file_name, perf->line_number, 
+					  "%s took %.2f ns (MAD %.2f), baseline %.2f ns (MAD %.2f) allows %.2f ns", perf->name, 
+					  median_ns, mad_ns, baseline->median_ns, baseline->mad_ns, allowed_ns);
+	}
+}
+
+int c_test_perf_next(c_test_perf_t *perf) {
+	if (perf->batch_iteration < perf->batch_size) {
+		perf->batch_iteration++;
+		return 1;
+	}
+
+	const uint64_t now_ns = c_test_monotonic_ns();
+	const uint64_t elapsed_ns = now_ns - perf->batch_start_ns;
+	if (perf->calibrating) {
+		// Batches double until one is long enough to time reliably, and the first such batch is a warm up.
+		if (elapsed_ns < kPerfMinBatchNs && perf->batch_size < ((uint64_t)1 << 40)) {
+			perf->batch_size *= 2;
+		} else {
+			perf->calibrating = 0;
+		}
+	} else {
+		perf->samples_ns[perf->sample_count++] = (double)elapsed_ns / (double)perf->batch_size;
+		if (C_TEST_PERF_SAMPLE_COUNT == perf->sample_count) {
+			c_test_perf_finish(perf);
+			return 0;
+		}
+	}
+
+	perf->batch_iteration = 1;
+	perf->batch_start_ns = c_test_monotonic_ns();
+	return 1;
+}
+
+
+// === Entry points === //
+
+uint32_t c_test_getenv_uint32(const char *name, uint32_t default_value) {
+	const char *value = getenv(name);
+	if (NULL == value || '\0' == *value) {
+		return default_value;
+	}
+	return (uint32_t)strtoul(value, NULL, 10);
+}
+
+void c_test_options_init(c_test_options_t *options) {
+	options->worker_count = 1;
+	options->isolate = 0;
+	options->isolation_batch_size = 1;
+	options->timeout_ms = 0;
+	options->run_tests = 1;
+	options->run_benchmarks = 0;
+	options->benchmark_min_time_ms = 100;
+	options->benchmark_repetitions = 10;
+	options->total_shards = c_test_getenv_uint32("C_TEST_TOTAL_SHARDS", 1);
+	options->shard_index = c_test_getenv_uint32("C_TEST_SHARD_INDEX", 0);
+	options->shard_timings_path = getenv("C_TEST_SHARD_TIMINGS");
+	options->timings_output_path = getenv("C_TEST_TIMINGS_OUTPUT");
+	options->filter = getenv("C_TEST_FILTER");
+	options->list_tests = 0;
+	options->fail_on_leaks = 0;
+	options->output = getenv("C_TEST_OUTPUT");
+	options->results_cache_path = getenv("C_TEST_RESULTS_CACHE");
+	options->failed_first = 0;
+	options->only_failed = 0;
+	options->only_changed = 0;
+	options->max_failures = 0;
+	options->time_budget_ms = 0;
+	options->repeat_count = 1;
+	options->shuffle = 0;
+	options->shuffle_seed = 0;
+	options->baseline_path = getenv("C_TEST_BASELINE");
+	options->record_baseline = 0;
+	options->fuzz = 0;
+	options->fuzz_time_ms = 10000;
+	options->fuzz_max_size = 4096;
+	options->fuzz_corpus_path = NULL;
+	options->fuzz_artifact_path = NULL;
+	options->fuzz_input_path = NULL;
+}
+
+void c_test_print_usage(const char *program) {
+	fprintf(stderr, 
+			"Usage: %s [options]\n"
+			"  --filter=PATTERNS       Run tests matching POSITIVE:PATTERNS-NEGATIVE:PATTERNS globs\n"
+			"  --list                  List the selected tests and benchmarks without running them\n"
+			"  --workers=N             Run tests on N threads, 0 for one per CPU\n"
+			"  --isolate               Run tests in forked child processes\n"
+			"  --batch-size=N          Tests per child process when isolated\n"
+			"  --timeout-ms=N          Fail tests running longer than N milliseconds; without --isolate the\n"
+			"                          first timeout also stops the run\n"
+			"  --max-failures=N        Skip the remaining tests after N failures\n"
+			"  --fail-fast             Skip the remaining tests after the first failure\n"
+			"  --time-budget-ms=N      Skip the tests not started within N milliseconds\n"
+			"  --repeat=N              Run every test N times and summarize the repetitions\n"
+			"  --shuffle[=SEED]        Run the tests in random order, reproducible with SEED\n"
+			"  --benchmarks            Also run benchmarks\n"
+			"  --benchmarks-only       Run benchmarks but no tests\n"
+			"  --benchmark-min-time-ms=N\n"
+			"  --benchmark-repetitions=N\n"
+			"  --total-shards=N        Split the tests into N shards\n"
+			"  --shard-index=N         Run shard N\n"
+			"  --shard-timings=PATH    Balance shards with timings from a previous run\n"
+			"  --timings-output=PATH   Write the duration of every test to PATH\n"
+			"  --fail-on-leaks         Fail tests that do not free what they allocate\n"
+			"  --output=FORMAT:PATH    Also report to PATH as jsonl or xml (JUnit)\n"
+			"  --results-cache=PATH    Remember test outcomes in PATH for the options below\n"
+			"  --failed-first          Run tests that failed last time first\n"
+			"  --only-failed           Run only tests that failed last time\n"
+			"  --only-changed          Run only tests that failed or whose source changed since they passed\n"
+			"  --baseline=PATH         Compare performance expectations with the baselines in PATH\n"
+			"  --record-baseline       Record performance baselines instead of comparing\n"
+			"  --fuzz                  Fuzz the selected FUZZ_TEST targets on --workers processes instead of testing\n"
+			"  --fuzz-time-ms=N        Fuzz each target for N milliseconds\n"
+			"  --fuzz-max-size=N       Generate inputs of up to N bytes\n"
+			"  --fuzz-corpus=DIR       Seed the corpus from DIR and save the minimized corpus there\n"
+			"  --fuzz-artifacts=DIR    Write reproducers of crashes, hangs and failures to DIR\n"
+			"  --fuzz-input=PATH       Run fuzz targets as tests on the input in PATH\n", 
+			program);
+}
+
+// Returns the value of "--name=value" when argument is that option, otherwise NULL.
+const char* c_test_option_value(const char *argument, const char *name) {
+	const size_t name_size = strlen(name);
+	if (0 == strncmp(argument, name, name_size) && '=' == argument[name_size]) {
+		return argument + name_size + 1;
 	}
+	return NULL;
+}
+
+int c_test_parse_options(c_test_options_t *options, int argc, const char **argv) {
+	for (int i = 1; i < argc; i++) {
+		const char *argument = argv[i];
+		const char *value = NULL;
+		if (NULL != (value = c_test_option_value(argument, "--filter"))) {
+			options->filter = value;
+		} else if (0 == strcmp(argument, "--list")) {
+			options->list_tests = 1;
+		} else if (NULL != (value = c_test_option_value(argument, "--workers"))) {
+			options->worker_count = strtoul(value, NULL, 10);
+		} else if (0 == strcmp(argument, "--isolate")) {
+			options->isolate = 1;
+		} else if (NULL != (value = c_test_option_value(argument, "--batch-size"))) {
+			options->isolation_batch_size = strtoul(value, NULL, 10);
+		} else if (NULL != (value = c_test_option_value(argument, "--timeout-ms"))) {
+			options->timeout_ms = strtoul(value, NULL, 10);
+		} else if (NULL != (value = c_test_option_value(argument, "--max-failures"))) {
+			options->max_failures = strtoul(value, NULL, 10);
+		} else if (0 == strcmp(argument, "--fail-fast")) {
+			options->max_failures = 1;
+		} else if (NULL != (value = c_test_option_value(argument, "--time-budget-ms"))) {
+			options->time_budget_ms = strtoul(value, NULL, 10);
+		} else if (NULL != (value = c_test_option_value(argument, "--repeat"))) {
+			options->repeat_count = strtoul(value, NULL, 10);
+		} else if (0 == strcmp(argument, "--shuffle")) {
+			options->shuffle = 1;
+		} else if (NULL != (value = c_test_option_value(argument, "--shuffle"))) {
+			options->shuffle = 1;
+			options->shuffle_seed = strtoull(value, NULL, 10);
+		} else if (0 == strcmp(argument, "--benchmarks")) {
+			options->run_benchmarks = 1;
+		} else if (0 == strcmp(argument, "--benchmarks-only")) {
+			options->run_tests = 0;
+			options->run_benchmarks = 1;
+		} else if (NULL != (value = c_test_option_value(argument, "--benchmark-min-time-ms"))) {
+			options->benchmark_min_time_ms = strtoul(value, NULL, 10);
+		} else if (NULL != (value = c_test_option_value(argument, "--benchmark-repetitions"))) {
+			options->benchmark_repetitions = strtoul(value, NULL, 10);
+		} else if (NULL != (value = c_test_option_value(argument, "--total-shards"))) {
+			options->total_shards = strtoul(value, NULL, 10);
+		} else if (NULL != (value = c_test_option_value(argument, "--shard-index"))) {
+			options->shard_index = strtoul(value, NULL, 10);
+		} else if (NULL != (value = c_test_option_value(argument, "--shard-timings"))) {
+			options->shard_timings_path = value;
+		} else if (NULL != (value = c_test_option_value(argument, "--timings-output"))) {
+			options->timings_output_path = value;
+		} else if (0 == strcmp(argument, "--fail-on-leaks")) {
+			options->fail_on_leaks = 1;
+		} else if (NULL != (value = c_test_option_value(argument, "--output"))) {
+			options->output = value;
+		} else if (NULL != (value = c_test_option_value(argument, "--results-cache"))) {
+			options->results_cache_path = value;
+		} else if (0 == strcmp(argument, "--failed-first")) {
+			options->failed_first = 1;
+		} else if (0 == strcmp(argument, "--only-failed")) {
+			options->only_failed = 1;
+		} else if (0 == strcmp(argument, "--only-changed")) {
+			options->only_changed = 1;
+		} else if (NULL != (value = c_test_option_value(argument, "--baseline"))) {
+			options->baseline_path = value;
+		} else if (0 == strcmp(argument, "--record-baseline")) {
+			options->record_baseline = 1;
+		} else if (0 == strcmp(argument, "--fuzz")) {
+			options->fuzz = 1;
+		} else if (NULL != (value = c_test_option_value(argument, "--fuzz-time-ms"))) {
+			options->fuzz_time_ms = strtoul(value, NULL, 10);
+		} else if (NULL != (value = c_test_option_value(argument, "--fuzz-max-size"))) {
+			options->fuzz_max_size = strtoul(value, NULL, 10);
+		} else if (NULL != (value = c_test_option_value(argument, "--fuzz-corpus"))) {
+			options->fuzz_corpus_path = value;
+		} else if (NULL != (value = c_test_option_value(argument, "--fuzz-artifacts"))) {
+			options->fuzz_artifact_path = value;
+		} else if (NULL != (value = c_test_option_value(argument, "--fuzz-input"))) {
+			options->fuzz_input_path = value;
+		} else {
+			fprintf(stderr, "c_test: unknown option %s\n", argument);
+			c_test_print_usage(argv[0]);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void c_test_list(const c_test_plan_t *plan, const c_test_context_t *context, const c_test_filter_t *filter, 
+				 const c_test_options_t *options) {
+	if (options->run_tests) {
+		for (uint32_t i = 0; i < plan->count; i++) {
+			const c_test_definition_t *test_definition = plan->entries[i].definition;
+			char suffix[C_TEST_CASE_SUFFIX_SIZE];
+			printf("%s.%s%s\n", test_definition->name_space, test_definition->test_name, 
+				   c_test_case_suffix(test_definition, plan->entries[i].case_index, suffix, sizeof(suffix)));
+		}
+	}
+	if (options->run_benchmarks) {
+		const c_test_definition_t *benchmark_definitions = 
+			(const c_test_definition_t *)context->benchmark_definitions.data;
+		for (uint32_t i = 0; i < context->benchmark_definitions.count; i++) {
+			if (c_test_filter_matches(filter, benchmark_definitions + i, 0)) {
+				printf("%s.%s\n", benchmark_definitions[i].name_space, benchmark_definitions[i].test_name);
+			}
+		}
+	}
+}
+
+int c_test_run_with_options(c_test_runner_t* runner, const c_test_options_t *options) {
+	c_test_context_t *context = c_test_get_context();
+
+	c_test_options_t default_options;
+	if (NULL == options) {
+		c_test_options_init(&default_options);
+		options = &default_options;
+	}
+
+	if (options->total_shards > 1 && options->shard_index >= options->total_shards) {
+		fprintf(stderr, "c_test: shard index %u is out of range for %u shards\n", options->shard_index, 
+				options->total_shards);
+		if (NULL != runner->destroy) {
+			runner->destroy(runner);
+		}
+		return 1;
+	}
+
+	if (NULL != options->fuzz_input_path && !c_test_load_fuzz_input(options->fuzz_input_path)) {
+		fprintf(stderr, "c_test: could not read fuzz input %s\n", options->fuzz_input_path);
+		if (NULL != runner->destroy) {
+			runner->destroy(runner);
+		}
+		return 1;
+	}
+
+	uint32_t worker_count = options->worker_count;
+	if (0 == worker_count) {
+		worker_count = c_test_online_cpu_count();
+	}
+
+	c_test_sort_definitions(&context->test_definitions);
+	c_test_sort_definitions(&context->benchmark_definitions);
+
+	c_test_plan_t plan;
+	c_test_plan_init(&plan, context, options);
+	c_test_filter_t filter;
+	c_test_filter_init(&filter, options->filter, &plan.arena);
+	c_test_plan_filter(&plan, &filter);
+	c_test_plan_shard(&plan, options->total_shards, options->shard_index, options->shard_timings_path);
+	const char *results_cache_path = options->results_cache_path;
+	if (NULL == results_cache_path && (options->failed_first || options->only_failed || options->only_changed)) {
+		results_cache_path = kDefaultResultsCachePath;
+	}
+	if (NULL != results_cache_path) {
+		c_test_plan_apply_results_cache(&plan, results_cache_path);
+	}
+	if (!c_test_plan_repeat(&plan, options->repeat_count)) {
+		c_test_filter_destroy(&filter);
+		c_test_plan_destroy(&plan);
+		c_test_release_fuzz_input();
+		if (NULL != runner->destroy) {
+			runner->destroy(runner);
+		}
+		return 1;
+	}
+	uint64_t shuffle_seed = options->shuffle_seed;
+	if (options->shuffle) {
+		if (0 == shuffle_seed) {
+			shuffle_seed = c_test_choose_shuffle_seed();
+		}
+		c_test_plan_shuffle(&plan, shuffle_seed);
+	}
+	c_test_plan_group_fixtures(&plan);
+
+	if (options->list_tests) {
+		c_test_list(&plan, context, &filter, options);
+		c_test_filter_destroy(&filter);
+		c_test_plan_destroy(&plan);
+		c_test_release_fuzz_input();
+		if (NULL != runner->destroy) {
+			runner->destroy(runner);
+		}
+		return 0;
+	}
+
+	if (NULL != options->output) {
+		c_test_runner_t *output_runner = c_test_create_output_runner(options->output);
+		if (NULL != output_runner) {
+			runner = c_test_create_tee_runner(runner, output_runner);
+		}
+	}
+
+	uint32_t failed_test_count = 0;
+	if (options->fuzz) {
+		failed_test_count = c_test_run_fuzz_tests(runner, &plan, options, worker_count);
+	} else if (options->run_tests) {
+		c_test_open_baselines(options);
+		if (NULL != runner->begin_tests) {
+			runner->begin_tests(runner, plan.count);
+		}
+
+#ifdef C_TEST_USE_FORK
+		if (options->isolate) {
+			failed_test_count = c_test_run_forked(runner, &plan, worker_count, options->isolation_batch_size, 
+												  options->timeout_ms);
+		} else
+#endif
+		{
+			// Timeouts jump out of the test body from a signal handler, installed for this run only.
+			if (0 != options->timeout_ms) {
+				c_test_watchdog_install();
+			}
+			if (worker_count > 1) {
+				failed_test_count = c_test_run_pool(runner, &plan, worker_count);
+			} else {
+				failed_test_count = c_test_run_serial(runner, &plan);
+			}
+			c_test_watchdog_uninstall();
+		}
+
+		if (NULL != runner->end_tests) {
+			runner->end_tests(runner, plan.count, failed_test_count);
+		}
+		c_test_close_baselines();
+
+		if (options->repeat_count > 1) {
+			c_test_print_repetitions(&plan);
+		}
+		if (options->shuffle) {
+			fflush(stdout);
+			fprintf(stderr, "\nShuffled with --shuffle=%llu\n", (unsigned long long)shuffle_seed);
+		}
+
+		if (NULL != options->timings_output_path) {
+			c_test_write_timings(options->timings_output_path, &plan);
+		}
+		if (NULL != results_cache_path) {
+			c_test_write_results_cache(results_cache_path, &plan);
+		}
+	}
+
+	// Benchmarks always run one at a time on the calling thread so they do not compete for the machine.
+	if (options->run_benchmarks) {
+		failed_test_count += c_test_run_benchmarks(runner, 
+												   (const c_test_definition_t *)context->benchmark_definitions.data, 
+												   context->benchmark_definitions.count, &filter, options, 
+												   &plan.arena);
+	}
+	c_test_filter_destroy(&filter);
+	c_test_plan_destroy(&plan);
+	c_test_release_fuzz_input();
 
 	int return_code = failed_test_count == 0 ? 0 : 1;
 	if (NULL != runner->destroy) {
@@ -395,3 +5755,26 @@ int c_test_run(c_test_runner_t* runner) {
 	}
 	return return_code;
 }
+
+int c_test_run(c_test_runner_t* runner) {
+	return c_test_run_with_options(runner, NULL);
+}
+
+int c_test_run_parallel(c_test_runner_t* runner, uint32_t worker_count) {
+	c_test_options_t options;
+	c_test_options_init(&options);
+	options.worker_count = worker_count;
+	return c_test_run_with_options(runner, &options);
+}
+
+int c_test_main(c_test_runner_t* runner, int argc, const char **argv) {
+	c_test_options_t options;
+	c_test_options_init(&options);
+	if (0 != c_test_parse_options(&options, argc, argv)) {
+		if (NULL != runner->destroy) {
+			runner->destroy(runner);
+		}
+		return 1;
+	}
+	return c_test_run_with_options(runner, &options);
+}
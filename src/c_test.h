@@ -11,14 +11,31 @@ struct c_test_runner;
 
 typedef void* (*c_test_setup_function_t)(void);
 typedef void (*c_test_teardown_function_t)(void*);
+typedef void (*c_test_reset_function_t)(void*);
 
 typedef void (*c_test_fixture_function_t)(struct c_test_runner *, void*);
 typedef void (*c_test_function_t)(struct c_test_runner *);
+typedef void (*c_test_benchmark_function_t)(struct c_test_runner *, uint64_t);
+typedef void (*c_test_param_function_t)(struct c_test_runner *, const void*);
+typedef void (*c_test_fuzz_function_t)(struct c_test_runner *, const uint8_t*, size_t);
 
 typedef struct {
 	c_test_setup_function_t setup;
 	c_test_teardown_function_t teardown;
 
+	// When setup_suite is set the fixture is shared: tests using it run back to back, setup_suite runs once before the 
+	// first of them and teardown_suite once after the last, and every test receives the shared data after reset (if 
+	// set) has restored it to a clean state. setup and teardown are not used for shared fixtures.
+	c_test_setup_function_t setup_suite;
+	c_test_teardown_function_t teardown_suite;
+	c_test_reset_function_t reset;
+} c_test_fixture_t;
+
+typedef struct {
+	c_test_setup_function_t setup;
+	c_test_teardown_function_t teardown;
+	const c_test_fixture_t *fixture;
+
 	const char *name_space;
 	const char *test_name;
 
@@ -27,18 +44,99 @@ typedef struct {
 
 	c_test_fixture_function_t test_fixture_function;
 	c_test_function_t test_function;
+	c_test_param_function_t test_param_function;
+	// Fuzz targets run as tests on an empty input (or fuzz_input_path), and are fuzzed by the fuzz option.
+	c_test_fuzz_function_t test_fuzz_function;
+	c_test_benchmark_function_t benchmark_function;
+
+	// A parameterized test runs once per element of its params array, which stays owned by the caller.
+	const void *params;
+	size_t param_size;
+	uint32_t param_count;
 } c_test_definition_t;
 
-typedef struct {
-	c_test_setup_function_t setup;
-	c_test_teardown_function_t teardown;
-} c_test_fixture_t;
-
 
+// Registers a test set up and torn down by a copy of fixture. The copy cannot be shared, so setup_suite, teardown_suite
+// and reset are not used; register tests of shared fixtures through c_test_add_fixture_test.
 void c_test_add_test_fixture(c_test_fixture_t fixture, c_test_fixture_function_t function, const char *fixture_name, 
-                      const char *test_name, const char *file_name, int line_number);
+                             const char *test_name, const char *file_name, int line_number);
+// Registers a test of the fixture at fixture, which must outlive the run. Tests sharing a fixture pass the same pointer.
+void c_test_add_fixture_test(const c_test_fixture_t *fixture, c_test_fixture_function_t function, 
+                             const char *fixture_name, const char *test_name, const char *file_name, int line_number);
 void c_test_add_test(c_test_function_t function, const char *name_space, const char *test_name, const char *file_name, 
               int line_number);
+void c_test_add_benchmark(c_test_benchmark_function_t function, const char *name_space, const char *benchmark_name, 
+                          const char *file_name, int line_number);
+// Registers a copy of a complete definition, or every definition of a table such as the one collected by
+// C_TEST_USE_SECTION_REGISTRATION. Definitions with benchmark_function set are registered as benchmarks. The table is
+// copied rather than run in place because registered tests share one vector with tests registered at run time, take
+// their setup and teardown from their fixture and are sorted by file and line before each run, since neither
+// constructors nor the linker keep them in a reproducible order.
+void c_test_add_definition(const c_test_definition_t *definition);
+void c_test_add_definition_table(const c_test_definition_t *const *begin, const c_test_definition_t *const *end);
+void c_test_add_test_param(c_test_param_function_t function, const void *params, size_t param_size, 
+                           uint32_t param_count, const char *name_space, const char *test_name, const char *file_name, 
+                           int line_number);
+void c_test_add_fuzz_test(c_test_fuzz_function_t function, const char *name_space, const char *test_name, 
+                          const char *file_name, int line_number);
+
+// Timings of one benchmark, in nanoseconds per iteration across repetitions.
+typedef struct {
+	uint64_t iterations;
+	uint32_t repetitions;
+
+	double mean_ns;
+	double min_ns;
+	double median_ns;
+	double p99_ns;
+	double stddev_ns;
+} c_test_benchmark_result_t;
+
+#define C_TEST_COUNTER_CYCLES (1u << 0)
+#define C_TEST_COUNTER_INSTRUCTIONS (1u << 1)
+#define C_TEST_COUNTER_CACHE_MISSES (1u << 2)
+#define C_TEST_COUNTER_BRANCH_MISSES (1u << 3)
+#define C_TEST_COUNTER_PAGE_FAULTS (1u << 4)
+#define C_TEST_COUNTER_CONTEXT_SWITCHES (1u << 5)
+
+// Events counted on the test's thread while the test body ran, when built with C_TEST_USE_PERF_COUNTERS. available has
+// a C_TEST_COUNTER_* bit set for every counter the platform could provide; the others are zero.
+typedef struct {
+	uint32_t available;
+
+	uint64_t cycles;
+	uint64_t instructions;
+	uint64_t cache_misses;
+	uint64_t branch_misses;
+	uint64_t page_faults;
+	uint64_t context_switches;
+} c_test_counters_t;
+
+// Measurements of a single test run, in nanoseconds. duration_ns comes from a monotonic clock; cpu_ns is the time the
+// test's thread spent on a CPU, split into user and system time where the platform reports it.
+typedef struct {
+	int success;
+	// Set for tests the run stopped before reaching, which count as successful.
+	int skipped;
+
+	uint64_t duration_ns;
+	uint64_t cpu_ns;
+	uint64_t user_cpu_ns;
+	uint64_t system_cpu_ns;
+
+	// Heap use of the test's thread while the test body ran, when built with C_TEST_TRACK_ALLOCATIONS. Sizes are the
+	// usable sizes reported by the allocator.
+	uint64_t allocation_count;
+	uint64_t allocated_bytes;
+	uint64_t peak_allocated_bytes;
+	uint64_t unfreed_allocation_count;
+	uint64_t unfreed_bytes;
+
+	c_test_counters_t counters;
+
+	// Assertions that passed on the test's thread, when the tests were compiled with C_TEST_COUNT_PASSES.
+	uint64_t passed_assertion_count;
+} c_test_result_t;
 
 #define ATTRIBUTE_PRINT_FORMAT(format_index, vararg_index) \
 	__attribute__ ((format (printf, format_index, vararg_index)))
@@ -49,26 +147,243 @@ typedef struct c_test_runner {
 					const char *format, ...) ATTRIBUTE_PRINT_FORMAT(5, 6);
 	void (*error)(struct c_test_runner *runner, const char *expression, const char *file_name, int line_number, 
 				  const char *format, ...) ATTRIBUTE_PRINT_FORMAT(5, 6);
+	// Called once per passed assertion when passes are counted and passed is NULL. Passes are only counted, so
+	// file_name and line_number are where the test is defined, not where the assertion is.
 	void (*success)(struct c_test_runner *runner, const char *file_name, int line_number);
+	// Called after each test body that passed assertions, with how many, when the tests count them (see
+	// C_TEST_COUNT_PASSES). Optional; without it success is called once per passed assertion.
+	void (*passed)(struct c_test_runner *runner, uint64_t passed_count);
 	void (*destroy)(struct c_test_runner *runner);
 
 	// Called before and after a test runs.
 	void (*begin_test)(struct c_test_runner *runner);
 	void (*end_test)(struct c_test_runner *runner, int test_success);
+	// Called instead of begin_test and end_test for a test skipped because the run stopped early. Optional.
+	void (*skip_test)(struct c_test_runner *runner);
 	
 	// Called before and after all tests run.
 	void (*begin_tests)(struct c_test_runner *runner, uint32_t test_count);
 	void (*end_tests)(struct c_test_runner *runner, uint32_t test_count, uint32_t failed_count);
 
+	// Called after each benchmark completes.
+	void (*benchmark_result)(struct c_test_runner *runner, const c_test_benchmark_result_t *result, int success);
+
+	// The runner passed to a test may be used from any thread the test starts and joins, and counts atomically there.
 	uint32_t error_count;
 
 	void *data;
 	const c_test_definition_t *current_test;
+	// Index of the running case within current_test->params, for parameterized tests.
+	uint32_t current_case;
+	// Set while end_test runs.
+	const c_test_result_t *current_result;
 } c_test_runner_t;
 
 c_test_runner_t* c_test_create_default_runner();
+// Runners streaming one record per test to a file as each test ends, so a crash keeps the records of the tests before
+// it. NULL if the file cannot be created.
+c_test_runner_t* c_test_create_jsonl_runner(const char *path);
+c_test_runner_t* c_test_create_junit_runner(const char *path);
+// Forwards every callback to both runners and destroys both with it.
+c_test_runner_t* c_test_create_tee_runner(c_test_runner_t *first, c_test_runner_t *second);
+
+typedef struct {
+	// Number of threads executing tests. 1 runs every test on the calling thread, 0 uses one thread per online CPU.
+	uint32_t worker_count;
+
+	// Runs tests in forked child processes, worker_count at a time, so a crash or hang only fails the test that caused
+	// it. Each child runs up to isolation_batch_size consecutive tests to amortize the cost of fork.
+	int isolate;
+	uint32_t isolation_batch_size;
+	// Fails a test that runs longer than this, 0 to wait forever. Isolated runs kill the child process; otherwise the
+	// test body is abandoned when built with C_TEST_USE_TIMEOUT_TIMER.
+	uint32_t timeout_ms;
+	// Skips the tests not started yet once this many tests failed, 0 for no limit.
+	uint32_t max_failures;
+	// Skips the tests not started within this many milliseconds of the run starting, 0 for no limit.
+	uint32_t time_budget_ms;
+	// Runs every selected test repeat_count times, summarizing the pass ratio and durations of each when above 1.
+	// Repetitions are independent entries of the run, so they spread over workers and child processes like any test.
+	uint32_t repeat_count;
+	// Runs the tests in an order shuffled by shuffle_seed, or by a seed chosen and printed for the run when it is 0.
+	int shuffle;
+	uint64_t shuffle_seed;
+
+	// Tests and benchmarks are selected independently, so one binary can serve both.
+	int run_tests;
+	int run_benchmarks;
+	// Each benchmark repetition runs enough iterations to take at least this long.
+	uint32_t benchmark_min_time_ms;
+	uint32_t benchmark_repetitions;
+
+	// Runs only the tests assigned to shard_index out of total_shards, defaulting to the C_TEST_TOTAL_SHARDS and
+	// C_TEST_SHARD_INDEX environment variables.
+	uint32_t total_shards;
+	uint32_t shard_index;
+	// Balances shards by the durations in a file written through timings_output_path on a previous run instead of by
+	// test count (C_TEST_SHARD_TIMINGS).
+	const char *shard_timings_path;
+	// Writes a "<namespace>.<test> <duration_ns>" line for every test that ran (C_TEST_TIMINGS_OUTPUT).
+	const char *timings_output_path;
+
+	// Selects tests and benchmarks by "<namespace>.<test>" globs, e.g. "Math.*:Strings.*-*Slow*" (C_TEST_FILTER).
+	const char *filter;
+	// Prints the selected tests and benchmarks instead of running them.
+	int list_tests;
+
+	// Fails tests whose body returns without freeing everything it allocated. Requires C_TEST_TRACK_ALLOCATIONS.
+	int fail_on_leaks;
+
+	// Also reports to a file, "jsonl:PATH" for JSON Lines or "xml:PATH" for JUnit XML (C_TEST_OUTPUT).
+	const char *output;
+
+	// Remembers which tests failed and the state of their source files across runs (C_TEST_RESULTS_CACHE). The modes
+	// below use ".c_test_results" when no path is set.
+	const char *results_cache_path;
+	// Runs the tests that failed last time before all others.
+	int failed_first;
+	// Runs only the tests that failed last time.
+	int only_failed;
+	// Runs only the tests that failed last time, are new, or whose source file changed since they last passed.
+	int only_changed;
+
+	// Baselines for EXPECT_FASTER_THAN_BASELINE, ".c_test_baselines" by default (C_TEST_BASELINE). With
+	// record_baseline the timed blocks record new baselines instead of being compared.
+	const char *baseline_path;
+	int record_baseline;
+
+	// Fuzzes every selected FUZZ_TEST for fuzz_time_ms instead of running the tests, on worker_count processes. Inputs
+	// are at most fuzz_max_size bytes.
+	int fuzz;
+	uint32_t fuzz_time_ms;
+	uint32_t fuzz_max_size;
+	// Directory of seed inputs, which also receives the minimized corpus after fuzzing. NULL keeps it in memory only.
+	const char *fuzz_corpus_path;
+	// Directory receiving a reproducer file for every distinct crash, hang or failed assertion, "." by default.
+	const char *fuzz_artifact_path;
+	// Runs fuzz targets as tests on the contents of this file instead of an empty input, e.g. a reproducer.
+	const char *fuzz_input_path;
+} c_test_options_t;
+
+void c_test_options_init(c_test_options_t *options);
+// Applies command line flags such as --filter=, --list and --workers= on top of options, returns non-zero on an unknown
+// flag.
+int c_test_parse_options(c_test_options_t *options, int argc, const char **argv);
 
 int c_test_run(c_test_runner_t* runner);
+int c_test_run_with_options(c_test_runner_t* runner, const c_test_options_t *options);
+int c_test_run_parallel(c_test_runner_t* runner, uint32_t worker_count);
+int c_test_main(c_test_runner_t* runner, int argc, const char **argv);
+
+// State of an EXPECT_FASTER_THAN_BASELINE block while it is sampled.
+#define C_TEST_PERF_SAMPLE_COUNT 31
+
+typedef struct {
+	c_test_runner_t *runner;
+	const char *name;
+	const char *expression;
+	double tolerance;
+	const char *file_name;
+	int line_number;
+
+	uint64_t batch_size;
+	uint64_t batch_iteration;
+	uint64_t batch_start_ns;
+	int calibrating;
+	uint32_t sample_count;
+	double samples_ns[C_TEST_PERF_SAMPLE_COUNT];
+} c_test_perf_t;
+
+c_test_perf_t c_test_perf_begin(c_test_runner_t *runner, const char *name, const char *expression, double tolerance, 
+                                const char *file_name, int line_number);
+// Returns non-zero while the block should run again.
+int c_test_perf_next(c_test_perf_t *perf);
+
+// Allocations made by the calling thread since its current test body started. Always 0 unless the library was built
+// with C_TEST_TRACK_ALLOCATIONS.
+uint64_t c_test_allocation_count();
+uint64_t c_test_allocated_bytes();
+// Non-zero when the library was built with C_TEST_TRACK_ALLOCATIONS. The allocation assertions fail without it rather
+// than pass without checking anything.
+int c_test_allocation_tracking_enabled();
+void c_test_allocation_tracking_missing(c_test_runner_t *runner, int is_failure, const char *expression, 
+                                        const char *file_name, int line_number) __attribute__((cold, noinline));
+
+// The out of line failure paths of the assertion macros, reporting through runner->failure and runner->error.
+void c_test_failure(c_test_runner_t *runner, const char *expression, const char *file_name, int line_number, 
+                    const char *format, ...) __attribute__((cold, noinline)) ATTRIBUTE_PRINT_FORMAT(5, 6);
+void c_test_error(c_test_runner_t *runner, const char *expression, const char *file_name, int line_number, 
+                  const char *format, ...) __attribute__((cold, noinline)) ATTRIBUTE_PRINT_FORMAT(5, 6);
+
+// An operand of a comparison macro, captured by C_TEST_VALUE for its failure message.
+typedef enum {
+	C_TEST_VALUE_SIGNED,
+	C_TEST_VALUE_UNSIGNED,
+	C_TEST_VALUE_CHAR,
+	C_TEST_VALUE_FLOAT,
+	C_TEST_VALUE_POINTER,
+	C_TEST_VALUE_STRING,
+} c_test_value_kind_t;
+
+typedef struct {
+	c_test_value_kind_t kind;
+	// Significant digits printed for floating point values.
+	int digits;
+	// Outside the union, since a union holding a long double is passed differently by older compilers.
+	long double float_value;
+	union {
+		int64_t signed_value;
+		uint64_t unsigned_value;
+		const void *pointer_value;
+		const char *string_value;
+	} value;
+} c_test_value_t;
+
+c_test_value_t c_test_signed_value(int64_t value);
+c_test_value_t c_test_unsigned_value(uint64_t value);
+c_test_value_t c_test_char_value(int value);
+c_test_value_t c_test_float_value(float value);
+c_test_value_t c_test_double_value(double value);
+c_test_value_t c_test_long_double_value(long double value);
+c_test_value_t c_test_pointer_value(const void *value);
+c_test_value_t c_test_string_value(const char *value);
+
+// The failure paths of the comparison macros, reporting both operands and the first differing byte respectively.
+void c_test_compare_failure(c_test_runner_t *runner, int is_failure, const char *expression, const char *file_name, 
+                            int line_number, const char *a_text, const char *b_text, const c_test_value_t *values, 
+                            const char *format, ...) __attribute__((cold, noinline)) ATTRIBUTE_PRINT_FORMAT(9, 10);
+void c_test_memeq_failure(c_test_runner_t *runner, int is_failure, const char *expression, const char *file_name, 
+                          int line_number, const void *a, const void *b, size_t size, const char *format, ...) 
+                          __attribute__((cold, noinline)) ATTRIBUTE_PRINT_FORMAT(9, 10);
+
+static inline double c_test_abs_difference(double a, double b) {
+	return a > b ? a - b : b - a;
+}
+
+// Number of representable values between a and b, or UINT64_MAX if either is NaN.
+static inline uint64_t c_test_double_ulp_distance(double a, double b) {
+	if (a != a || b != b) {
+		return UINT64_MAX;
+	}
+	union { double value; int64_t bits; } a_bits = {a}, b_bits = {b};
+	// Orders negative values below positive ones, with both zeros at 0.
+	const int64_t a_ordered = a_bits.bits < 0 ? INT64_MIN - a_bits.bits : a_bits.bits;
+	const int64_t b_ordered = b_bits.bits < 0 ? INT64_MIN - b_bits.bits : b_bits.bits;
+	return a_ordered > b_ordered ? (uint64_t)a_ordered - (uint64_t)b_ordered : (uint64_t)b_ordered - (uint64_t)a_ordered;
+}
+
+static inline uint64_t c_test_float_ulp_distance(float a, float b) {
+	if (a != a || b != b) {
+		return UINT64_MAX;
+	}
+	union { float value; int32_t bits; } a_bits = {a}, b_bits = {b};
+	const int64_t a_ordered = a_bits.bits < 0 ? (int64_t)INT32_MIN - a_bits.bits : a_bits.bits;
+	const int64_t b_ordered = b_bits.bits < 0 ? (int64_t)INT32_MIN - b_bits.bits : b_bits.bits;
+	return a_ordered > b_ordered ? (uint64_t)(a_ordered - b_ordered) : (uint64_t)(b_ordered - a_ordered);
+}
+
+// Assertions passed by the calling thread, counted when the tests are compiled with C_TEST_COUNT_PASSES.
+extern __thread uint64_t c_test_passed_assertions __attribute__((tls_model("initial-exec")));
 
 #ifdef __cplusplus
 }
@@ -82,13 +397,40 @@ int c_test_run(c_test_runner_t* runner);
 #define C_TEST_CONSTRUCTOR_FUNCTION(_name) \
 	__attribute__ ((constructor)) void __c_test_ctor_ ## _name  ()
 
-#define C_TEST_TEST_FIXTURE2(fixture, test_name, fixture_name_cstr, test_name_cstr, file_cstr, line, test_symbol)  \
+#ifdef C_TEST_USE_SECTION_REGISTRATION
+
+// Definitions are collected by the linker instead of constructors: each test adds a pointer to its constant definition
+// to the c_test_definitions section, whose bounds RUN_ALL_TESTS hands to the library. The section holds pointers
+// because the linker may pad it between object files, which would misalign a table of definitions. Only tests linked
+// into the executable calling RUN_ALL_TESTS are found.
+#define C_TEST_REGISTER_DEFINITION(_name, ...) \
+	static const c_test_definition_t __c_test_definition_ ## _name = { __VA_ARGS__ }; \
+	__attribute__ ((used, section("c_test_definitions"))) \
+	static const c_test_definition_t *const __c_test_definition_entry_ ## _name = &__c_test_definition_ ## _name;
+
+extern const c_test_definition_t *const __start_c_test_definitions[] __attribute__ ((weak, visibility("hidden")));
+extern const c_test_definition_t *const __stop_c_test_definitions[] __attribute__ ((weak, visibility("hidden")));
+
+#define C_TEST_REGISTER_DEFINITION_TABLE() \
+	c_test_add_definition_table(__start_c_test_definitions, __stop_c_test_definitions)
+
+#else
+
+#define C_TEST_REGISTER_DEFINITION(_name, ...) \
+	static const c_test_definition_t __c_test_definition_ ## _name = { __VA_ARGS__ }; \
+	C_TEST_CONSTRUCTOR_FUNCTION(_name) { \
+		c_test_add_definition(&__c_test_definition_ ## _name); \
+	}
+
+#define C_TEST_REGISTER_DEFINITION_TABLE() ((void)0)
+
+#endif
+
+#define C_TEST_TEST_FIXTURE2(fixture_variable, name, fixture_name_cstr, test_name_cstr, file_cstr, line, test_symbol)  \
     /* Forward declare test body */ \
     void test_symbol (c_test_runner_t *, void*); \
 	/* Attach test body to our global context */ \
-	C_TEST_CONSTRUCTOR_FUNCTION(fixture ## _ ## test_name ## _ ## line) { \
-		c_test_add_test_fixture(fixture, test_symbol, fixture_name_cstr, test_name_cstr, file_cstr, line); \
-	} \
+	C_TEST_REGISTER_DEFINITION(fixture_variable ## _ ## name ## _ ## line, .fixture = &fixture_variable, .name_space = fixture_name_cstr, .test_name = test_name_cstr, .file_name = file_cstr, .line_number = line, .test_fixture_function = test_symbol) \
 	/* Declare test function */ \
 	void test_symbol (c_test_runner_t *__runner, void* data_)
 
@@ -98,13 +440,11 @@ int c_test_run(c_test_runner_t* runner);
 #define C_TEST_TEST_FIXTURE0(fixture, test_name, fixture_name_cstr, test_name_cstr, file_cstr, line) \
 	C_TEST_TEST_FIXTURE1(fixture, test_name, fixture_name_cstr, test_name_cstr, file_cstr, line)
 
-#define C_TEST_TEST2(namespace, test_name, namespace_name_cstr, test_name_cstr, file_cstr, line, test_symbol)  \
+#define C_TEST_TEST2(namespace, name, namespace_name_cstr, test_name_cstr, file_cstr, line, test_symbol)  \
     /* Forward declare test body */ \
     void test_symbol (c_test_runner_t *); \
 	/* Attach test body to our global context */ \
-	C_TEST_CONSTRUCTOR_FUNCTION(namespace ## _ ## test_name ## _ ## line) { \
-		c_test_add_test(test_symbol, namespace_name_cstr, test_name_cstr, file_cstr, line); \
-	} \
+	C_TEST_REGISTER_DEFINITION(namespace ## _ ## name ## _ ## line, .name_space = namespace_name_cstr, .test_name = test_name_cstr, .file_name = file_cstr, .line_number = line, .test_function = test_symbol) \
 	/* Declare test function */ \
 	void test_symbol (c_test_runner_t *__runner)
 
@@ -114,39 +454,160 @@ int c_test_run(c_test_runner_t* runner);
 #define C_TEST_TEST0(namespace, test_name, namespace_name_cstr, test_name_cstr, file_cstr, line) \
 	C_TEST_TEST1(namespace, test_name, namespace_name_cstr, test_name_cstr, file_cstr, line)
 
+#define C_TEST_TEST_P2(namespace, name, type, param_array, namespace_name_cstr, test_name_cstr, file_cstr, line, test_symbol)  \
+    /* Forward declare test body */ \
+    void test_symbol (c_test_runner_t *, const type *); \
+	/* Adapt the test body to untyped parameters */ \
+	void test_symbol ## _case (c_test_runner_t *runner, const void *param) { test_symbol(runner, (const type *)param); } \
+	/* Attach test body and parameters to our global context */ \
+	C_TEST_REGISTER_DEFINITION(namespace ## _ ## name ## _ ## line, .name_space = namespace_name_cstr, .test_name = test_name_cstr, .file_name = file_cstr, .line_number = line, .test_param_function = test_symbol ## _case, .params = (param_array), .param_size = sizeof((param_array)[0]), .param_count = sizeof(param_array) / sizeof((param_array)[0])) \
+	/* Declare test function */ \
+	void test_symbol (c_test_runner_t *__runner, const type *param_)
+
+#define C_TEST_TEST_P1(namespace, test_name, type, params, namespace_name_cstr, test_name_cstr, file_cstr, line)  \
+	C_TEST_TEST_P2(namespace, test_name, type, params, namespace_name_cstr, test_name_cstr, file_cstr, line, __c_test_test_ ## namespace ## _ ## test_name ## _ ## line )
+
+#define C_TEST_TEST_P0(namespace, test_name, type, params, namespace_name_cstr, test_name_cstr, file_cstr, line) \
+	C_TEST_TEST_P1(namespace, test_name, type, params, namespace_name_cstr, test_name_cstr, file_cstr, line)
+
+#define C_TEST_FUZZ_TEST2(namespace, name, namespace_name_cstr, test_name_cstr, file_cstr, line, test_symbol)  \
+    /* Forward declare test body */ \
+    void test_symbol (c_test_runner_t *, const uint8_t *, size_t); \
+	/* Attach test body to our global context */ \
+	C_TEST_REGISTER_DEFINITION(namespace ## _ ## name ## _ ## line, .name_space = namespace_name_cstr, .test_name = test_name_cstr, .file_name = file_cstr, .line_number = line, .test_fuzz_function = test_symbol) \
+	/* Declare test function */ \
+	void test_symbol (c_test_runner_t *__runner, const uint8_t *data_, size_t size_)
+
+#define C_TEST_FUZZ_TEST1(namespace, test_name, namespace_name_cstr, test_name_cstr, file_cstr, line)  \
+	C_TEST_FUZZ_TEST2(namespace, test_name, namespace_name_cstr, test_name_cstr, file_cstr, line, __c_test_fuzz_ ## namespace ## _ ## test_name ## _ ## line )
+
+#define C_TEST_FUZZ_TEST0(namespace, test_name, namespace_name_cstr, test_name_cstr, file_cstr, line) \
+	C_TEST_FUZZ_TEST1(namespace, test_name, namespace_name_cstr, test_name_cstr, file_cstr, line)
+
+#define C_TEST_BENCHMARK2(namespace, benchmark_name, namespace_name_cstr, benchmark_name_cstr, file_cstr, line, benchmark_symbol)  \
+    /* Forward declare benchmark body */ \
+    void benchmark_symbol (c_test_runner_t *, uint64_t); \
+	/* Attach benchmark body to our global context */ \
+	C_TEST_REGISTER_DEFINITION(namespace ## _ ## benchmark_name ## _ ## line, .name_space = namespace_name_cstr, .test_name = benchmark_name_cstr, .file_name = file_cstr, .line_number = line, .benchmark_function = benchmark_symbol) \
+	/* Declare benchmark function */ \
+	void benchmark_symbol (c_test_runner_t *__runner, uint64_t iterations_)
+
+#define C_TEST_BENCHMARK1(namespace, benchmark_name, namespace_name_cstr, benchmark_name_cstr, file_cstr, line)  \
+	C_TEST_BENCHMARK2(namespace, benchmark_name, namespace_name_cstr, benchmark_name_cstr, file_cstr, line, __c_test_benchmark_ ## namespace ## _ ## benchmark_name ## _ ## line )
+
+#define C_TEST_BENCHMARK0(namespace, benchmark_name, namespace_name_cstr, benchmark_name_cstr, file_cstr, line) \
+	C_TEST_BENCHMARK1(namespace, benchmark_name, namespace_name_cstr, benchmark_name_cstr, file_cstr, line)
+
 
 // === Assertion Macros === //
 
-#define FAIL(...) return __runner->failure(__runner, "", __FILE__, __LINE__, __VA_ARGS__);
-#define SUCCESS(...) return __runner->success(__runner, "", __FILE__, __LINE__, __VA_ARGS__);
-
-#define ASSERT_FALSE(a, ...) if ((a)) { return __runner->failure(__runner,  "ASSERT_FALSE("#a")", __FILE__, __LINE__, __VA_ARGS__); }
-#define ASSERT_TRUE(a, ...) if (!((a))) { return __runner->failure(__runner,  "ASSERT_TRUE("#a")", __FILE__, __LINE__, __VA_ARGS__); }
-
-#define ASSERT_GT(a, b, ...) if ((a) <= (b)) { return __runner->failure(__runner, "ASSERT_GT("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
-#define ASSERT_STRNE(a, b, ...) if (strcmp((a), (b)) == 0) { return __runner->failure(__runner, "ASSERT_STRNE("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
-#define ASSERT_LT(a, b, ...) if ((a) >= (b)) { return __runner->failure(__runner, "ASSERT_LT("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
-#define ASSERT_LE(a, b, ...) if ((a) > (b)) { return __runner->failure(__runner, "ASSERT_LE("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
-#define ASSERT_STRCASNE(a, b, ...) if (strcasecmp((a), (b)) == 0) { return __runner->failure(__runner, "ASSERT_STRCASNE("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
-#define ASSERT_GE(a, b, ...) if ((a) < (b)) { return __runner->failure(__runner, "ASSERT_GE("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
-#define ASSERT_STREQ(a, b, ...) if (strcmp((a), (b)) != 0) { return __runner->failure(__runner, "ASSERT_STREQ("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
-#define ASSERT_STRCASEQ(a, b, ...) if (strcasecmp((a), (b)) != 0) { return __runner->failure(__runner, "ASSERT_STRCASEQ("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
-#define ASSERT_EQ(a, b, ...) if ((a) != (b)) { return __runner->failure(__runner, "ASSERT_EQ("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
-#define ASSERT_NE(a, b, ...) if ((a) == (b)) { return __runner->failure(__runner, "ASSERT_NE("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
-
-#define EXPECT_FALSE(a, ...) if ((a)) {  __runner->error(__runner,  "EXPECT_FALSE("#a")", __FILE__, __LINE__, __VA_ARGS__); }
-#define EXPECT_TRUE(a, ...) if (!((a))) {  __runner->error(__runner,  "EXPECT_TRUE("#a")", __FILE__, __LINE__, __VA_ARGS__); }
-
-#define EXPECT_GT(a, b, ...) if ((a) <= (b)) {  __runner->error(__runner, "EXPECT_GT("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
-#define EXPECT_STRNE(a, b, ...) if (strcmp((a), (b)) == 0) {  __runner->error(__runner, "EXPECT_STRNE("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
-#define EXPECT_LT(a, b, ...) if ((a) >= (b)) {  __runner->error(__runner, "EXPECT_LT("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
-#define EXPECT_LE(a, b, ...) if ((a) > (b)) {  __runner->error(__runner, "EXPECT_LE("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
-#define EXPECT_STRCASNE(a, b, ...) if (strcasecmp((a), (b)) == 0) {  __runner->error(__runner, "EXPECT_STRCASNE("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
-#define EXPECT_GE(a, b, ...) if ((a) < (b)) {  __runner->error(__runner, "EXPECT_GE("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
-#define EXPECT_STREQ(a, b, ...) if (strcmp((a), (b)) != 0) {  __runner->error(__runner, "EXPECT_STREQ("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
-#define EXPECT_STRCASEQ(a, b, ...) if (strcasecmp((a), (b)) != 0) {  __runner->error(__runner, "EXPECT_STRCASEQ("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
-#define EXPECT_EQ(a, b, ...) if ((a) != (b)) {  __runner->error(__runner, "EXPECT_EQ("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
-#define EXPECT_NE(a, b, ...) if ((a) == (b)) {  __runner->error(__runner, "EXPECT_NE("#a", "#b")", __FILE__, __LINE__, __VA_ARGS__); }
+#define C_TEST_UNLIKELY(condition) __builtin_expect(!!(condition), 0)
+
+// Comparison macros capture their operands in locals of the operands' own type. In C++ pointers compare against nullptr
+// there, as NULL may be an integer.
+#ifdef __cplusplus
+#define C_TEST_AUTO auto
+
+// Measures in float ULPs when the operands add up to a float, as C_TEST_ULP_DISTANCE does in C.
+extern "C++" {
+inline uint64_t c_test_ulp_distance(float, double a, double b) { return c_test_float_ulp_distance((float)a, (float)b); }
+template <typename T> inline uint64_t c_test_ulp_distance(T, double a, double b) {
+	return c_test_double_ulp_distance(a, b);
+}
+}
+
+#define C_TEST_ULP_DISTANCE(a, b) c_test_ulp_distance((a) + (b), (a), (b))
+#else
+#define C_TEST_AUTO __auto_type
+
+#define C_TEST_ULP_DISTANCE(a, b) \
+	_Generic((a) + (b), float: c_test_float_ulp_distance, default: c_test_double_ulp_distance)((a), (b))
+#endif
+
+// Defining C_TEST_COUNT_PASSES before including this header makes every passing assertion on the test's thread
+// increment a thread local counter, reported once per test through the runner's passed callback.
+#ifdef C_TEST_COUNT_PASSES
+#define C_TEST_PASS() ((void)c_test_passed_assertions++)
+#else
+#define C_TEST_PASS() ((void)0)
+#endif
+
+#define FAIL(...) { c_test_failure(__runner, "", __FILE__, __LINE__, __VA_ARGS__); return; }
+#define SUCCESS(...) { C_TEST_PASS(); return; }
+
+#ifdef __cplusplus
+extern "C++" {
+inline c_test_value_t c_test_value(bool value) { return c_test_unsigned_value(value); }
+inline c_test_value_t c_test_value(char value) { return c_test_char_value(value); }
+inline c_test_value_t c_test_value(signed char value) { return c_test_signed_value(value); }
+inline c_test_value_t c_test_value(unsigned char value) { return c_test_unsigned_value(value); }
+inline c_test_value_t c_test_value(short value) { return c_test_signed_value(value); }
+inline c_test_value_t c_test_value(unsigned short value) { return c_test_unsigned_value(value); }
+inline c_test_value_t c_test_value(int value) { return c_test_signed_value(value); }
+inline c_test_value_t c_test_value(unsigned int value) { return c_test_unsigned_value(value); }
+inline c_test_value_t c_test_value(long value) { return c_test_signed_value(value); }
+inline c_test_value_t c_test_value(unsigned long value) { return c_test_unsigned_value(value); }
+inline c_test_value_t c_test_value(long long value) { return c_test_signed_value(value); }
+inline c_test_value_t c_test_value(unsigned long long value) { return c_test_unsigned_value(value); }
+inline c_test_value_t c_test_value(float value) { return c_test_float_value(value); }
+inline c_test_value_t c_test_value(double value) { return c_test_double_value(value); }
+inline c_test_value_t c_test_value(long double value) { return c_test_long_double_value(value); }
+template <typename T> inline c_test_value_t c_test_value(T *value) { return c_test_pointer_value((const void*)value); }
+inline c_test_value_t c_test_value(decltype(nullptr)) { return c_test_pointer_value(NULL); }
+}
+#define C_TEST_VALUE(value) c_test_value(value)
+#else
+#define C_TEST_VALUE(value) _Generic((value), _Bool: c_test_unsigned_value, char: c_test_char_value, signed char: c_test_signed_value, unsigned char: c_test_unsigned_value, short: c_test_signed_value, unsigned short: c_test_unsigned_value, int: c_test_signed_value, unsigned int: c_test_unsigned_value, long: c_test_signed_value, unsigned long: c_test_unsigned_value, long long: c_test_signed_value, unsigned long long: c_test_unsigned_value, float: c_test_float_value, double: c_test_double_value, long double: c_test_long_double_value, default: c_test_pointer_value)(value)
+#endif
+
+#define ASSERT_TRUE(a, ...) if (C_TEST_UNLIKELY(!((a)))) { c_test_failure(__runner, "ASSERT_TRUE("#a")", __FILE__, __LINE__, __VA_ARGS__); return; } else C_TEST_PASS()
+#define ASSERT_FALSE(a, ...) if (C_TEST_UNLIKELY((a))) { c_test_failure(__runner, "ASSERT_FALSE("#a")", __FILE__, __LINE__, __VA_ARGS__); return; } else C_TEST_PASS()
+
+#define ASSERT_EQ(a, b, ...) { C_TEST_AUTO __c_test_a = (a); C_TEST_AUTO __c_test_b = (b); if (C_TEST_UNLIKELY(__c_test_a != __c_test_b)) { const c_test_value_t __c_test_values[2] = {C_TEST_VALUE(__c_test_a), C_TEST_VALUE(__c_test_b)}; c_test_compare_failure(__runner, 1, "ASSERT_EQ("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); return; } else C_TEST_PASS(); }
+#define ASSERT_NE(a, b, ...) { C_TEST_AUTO __c_test_a = (a); C_TEST_AUTO __c_test_b = (b); if (C_TEST_UNLIKELY(__c_test_a == __c_test_b)) { const c_test_value_t __c_test_values[2] = {C_TEST_VALUE(__c_test_a), C_TEST_VALUE(__c_test_b)}; c_test_compare_failure(__runner, 1, "ASSERT_NE("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); return; } else C_TEST_PASS(); }
+#define ASSERT_LT(a, b, ...) { C_TEST_AUTO __c_test_a = (a); C_TEST_AUTO __c_test_b = (b); if (C_TEST_UNLIKELY(__c_test_a >= __c_test_b)) { const c_test_value_t __c_test_values[2] = {C_TEST_VALUE(__c_test_a), C_TEST_VALUE(__c_test_b)}; c_test_compare_failure(__runner, 1, "ASSERT_LT("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); return; } else C_TEST_PASS(); }
+#define ASSERT_LE(a, b, ...) { C_TEST_AUTO __c_test_a = (a); C_TEST_AUTO __c_test_b = (b); if (C_TEST_UNLIKELY(__c_test_a > __c_test_b)) { const c_test_value_t __c_test_values[2] = {C_TEST_VALUE(__c_test_a), C_TEST_VALUE(__c_test_b)}; c_test_compare_failure(__runner, 1, "ASSERT_LE("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); return; } else C_TEST_PASS(); }
+#define ASSERT_GT(a, b, ...) { C_TEST_AUTO __c_test_a = (a); C_TEST_AUTO __c_test_b = (b); if (C_TEST_UNLIKELY(__c_test_a <= __c_test_b)) { const c_test_value_t __c_test_values[2] = {C_TEST_VALUE(__c_test_a), C_TEST_VALUE(__c_test_b)}; c_test_compare_failure(__runner, 1, "ASSERT_GT("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); return; } else C_TEST_PASS(); }
+#define ASSERT_GE(a, b, ...) { C_TEST_AUTO __c_test_a = (a); C_TEST_AUTO __c_test_b = (b); if (C_TEST_UNLIKELY(__c_test_a < __c_test_b)) { const c_test_value_t __c_test_values[2] = {C_TEST_VALUE(__c_test_a), C_TEST_VALUE(__c_test_b)}; c_test_compare_failure(__runner, 1, "ASSERT_GE("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); return; } else C_TEST_PASS(); }
+#define ASSERT_STREQ(a, b, ...) { const char *__c_test_a = (a); const char *__c_test_b = (b); if (C_TEST_UNLIKELY(strcmp(__c_test_a, __c_test_b) != 0)) { const c_test_value_t __c_test_values[2] = {c_test_string_value(__c_test_a), c_test_string_value(__c_test_b)}; c_test_compare_failure(__runner, 1, "ASSERT_STREQ("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); return; } else C_TEST_PASS(); }
+#define ASSERT_STRNE(a, b, ...) { const char *__c_test_a = (a); const char *__c_test_b = (b); if (C_TEST_UNLIKELY(strcmp(__c_test_a, __c_test_b) == 0)) { const c_test_value_t __c_test_values[2] = {c_test_string_value(__c_test_a), c_test_string_value(__c_test_b)}; c_test_compare_failure(__runner, 1, "ASSERT_STRNE("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); return; } else C_TEST_PASS(); }
+#define ASSERT_STRCASEQ(a, b, ...) { const char *__c_test_a = (a); const char *__c_test_b = (b); if (C_TEST_UNLIKELY(strcasecmp(__c_test_a, __c_test_b) != 0)) { const c_test_value_t __c_test_values[2] = {c_test_string_value(__c_test_a), c_test_string_value(__c_test_b)}; c_test_compare_failure(__runner, 1, "ASSERT_STRCASEQ("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); return; } else C_TEST_PASS(); }
+#define ASSERT_STRCASNE(a, b, ...) { const char *__c_test_a = (a); const char *__c_test_b = (b); if (C_TEST_UNLIKELY(strcasecmp(__c_test_a, __c_test_b) == 0)) { const c_test_value_t __c_test_values[2] = {c_test_string_value(__c_test_a), c_test_string_value(__c_test_b)}; c_test_compare_failure(__runner, 1, "ASSERT_STRCASNE("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); return; } else C_TEST_PASS(); }
+
+#define ASSERT_NEAR(a, b, abs_error, ...) { const double __c_test_a = (a); const double __c_test_b = (b); if (C_TEST_UNLIKELY(!(c_test_abs_difference(__c_test_a, __c_test_b) <= (abs_error)))) { const c_test_value_t __c_test_values[2] = {C_TEST_VALUE(__c_test_a), C_TEST_VALUE(__c_test_b)}; c_test_compare_failure(__runner, 1, "ASSERT_NEAR("#a", "#b", "#abs_error")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); return; } else C_TEST_PASS(); }
+#define ASSERT_ULP_EQ(a, b, max_ulps, ...) { C_TEST_AUTO __c_test_a = (a); C_TEST_AUTO __c_test_b = (b); if (C_TEST_UNLIKELY(C_TEST_ULP_DISTANCE(__c_test_a, __c_test_b) > (uint64_t)(max_ulps))) { const c_test_value_t __c_test_values[2] = {C_TEST_VALUE(__c_test_a), C_TEST_VALUE(__c_test_b)}; c_test_compare_failure(__runner, 1, "ASSERT_ULP_EQ("#a", "#b", "#max_ulps")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); return; } else C_TEST_PASS(); }
+#define ASSERT_MEMEQ(a, b, size, ...) { const void *__c_test_a = (a); const void *__c_test_b = (b); const size_t __c_test_size = (size); if (C_TEST_UNLIKELY(memcmp(__c_test_a, __c_test_b, __c_test_size) != 0)) { c_test_memeq_failure(__runner, 1, "ASSERT_MEMEQ("#a", "#b", "#size")", __FILE__, __LINE__, __c_test_a, __c_test_b, __c_test_size, __VA_ARGS__); return; } else C_TEST_PASS(); }
+
+#define EXPECT_TRUE(a, ...) if (C_TEST_UNLIKELY(!((a)))) { c_test_error(__runner, "EXPECT_TRUE("#a")", __FILE__, __LINE__, __VA_ARGS__); } else C_TEST_PASS()
+#define EXPECT_FALSE(a, ...) if (C_TEST_UNLIKELY((a))) { c_test_error(__runner, "EXPECT_FALSE("#a")", __FILE__, __LINE__, __VA_ARGS__); } else C_TEST_PASS()
+
+#define EXPECT_EQ(a, b, ...) { C_TEST_AUTO __c_test_a = (a); C_TEST_AUTO __c_test_b = (b); if (C_TEST_UNLIKELY(__c_test_a != __c_test_b)) { const c_test_value_t __c_test_values[2] = {C_TEST_VALUE(__c_test_a), C_TEST_VALUE(__c_test_b)}; c_test_compare_failure(__runner, 0, "EXPECT_EQ("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); } else C_TEST_PASS(); }
+#define EXPECT_NE(a, b, ...) { C_TEST_AUTO __c_test_a = (a); C_TEST_AUTO __c_test_b = (b); if (C_TEST_UNLIKELY(__c_test_a == __c_test_b)) { const c_test_value_t __c_test_values[2] = {C_TEST_VALUE(__c_test_a), C_TEST_VALUE(__c_test_b)}; c_test_compare_failure(__runner, 0, "EXPECT_NE("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); } else C_TEST_PASS(); }
+#define EXPECT_LT(a, b, ...) { C_TEST_AUTO __c_test_a = (a); C_TEST_AUTO __c_test_b = (b); if (C_TEST_UNLIKELY(__c_test_a >= __c_test_b)) { const c_test_value_t __c_test_values[2] = {C_TEST_VALUE(__c_test_a), C_TEST_VALUE(__c_test_b)}; c_test_compare_failure(__runner, 0, "EXPECT_LT("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); } else C_TEST_PASS(); }
+#define EXPECT_LE(a, b, ...) { C_TEST_AUTO __c_test_a = (a); C_TEST_AUTO __c_test_b = (b); if (C_TEST_UNLIKELY(__c_test_a > __c_test_b)) { const c_test_value_t __c_test_values[2] = {C_TEST_VALUE(__c_test_a), C_TEST_VALUE(__c_test_b)}; c_test_compare_failure(__runner, 0, "EXPECT_LE("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); } else C_TEST_PASS(); }
+#define EXPECT_GT(a, b, ...) { C_TEST_AUTO __c_test_a = (a); C_TEST_AUTO __c_test_b = (b); if (C_TEST_UNLIKELY(__c_test_a <= __c_test_b)) { const c_test_value_t __c_test_values[2] = {C_TEST_VALUE(__c_test_a), C_TEST_VALUE(__c_test_b)}; c_test_compare_failure(__runner, 0, "EXPECT_GT("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); } else C_TEST_PASS(); }
+#define EXPECT_GE(a, b, ...) { C_TEST_AUTO __c_test_a = (a); C_TEST_AUTO __c_test_b = (b); if (C_TEST_UNLIKELY(__c_test_a < __c_test_b)) { const c_test_value_t __c_test_values[2] = {C_TEST_VALUE(__c_test_a), C_TEST_VALUE(__c_test_b)}; c_test_compare_failure(__runner, 0, "EXPECT_GE("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); } else C_TEST_PASS(); }
+#define EXPECT_STREQ(a, b, ...) { const char *__c_test_a = (a); const char *__c_test_b = (b); if (C_TEST_UNLIKELY(strcmp(__c_test_a, __c_test_b) != 0)) { const c_test_value_t __c_test_values[2] = {c_test_string_value(__c_test_a), c_test_string_value(__c_test_b)}; c_test_compare_failure(__runner, 0, "EXPECT_STREQ("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); } else C_TEST_PASS(); }
+#define EXPECT_STRNE(a, b, ...) { const char *__c_test_a = (a); const char *__c_test_b = (b); if (C_TEST_UNLIKELY(strcmp(__c_test_a, __c_test_b) == 0)) { const c_test_value_t __c_test_values[2] = {c_test_string_value(__c_test_a), c_test_string_value(__c_test_b)}; c_test_compare_failure(__runner, 0, "EXPECT_STRNE("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); } else C_TEST_PASS(); }
+#define EXPECT_STRCASEQ(a, b, ...) { const char *__c_test_a = (a); const char *__c_test_b = (b); if (C_TEST_UNLIKELY(strcasecmp(__c_test_a, __c_test_b) != 0)) { const c_test_value_t __c_test_values[2] = {c_test_string_value(__c_test_a), c_test_string_value(__c_test_b)}; c_test_compare_failure(__runner, 0, "EXPECT_STRCASEQ("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); } else C_TEST_PASS(); }
+#define EXPECT_STRCASNE(a, b, ...) { const char *__c_test_a = (a); const char *__c_test_b = (b); if (C_TEST_UNLIKELY(strcasecmp(__c_test_a, __c_test_b) == 0)) { const c_test_value_t __c_test_values[2] = {c_test_string_value(__c_test_a), c_test_string_value(__c_test_b)}; c_test_compare_failure(__runner, 0, "EXPECT_STRCASNE("#a", "#b")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); } else C_TEST_PASS(); }
+
+#define EXPECT_NEAR(a, b, abs_error, ...) { const double __c_test_a = (a); const double __c_test_b = (b); if (C_TEST_UNLIKELY(!(c_test_abs_difference(__c_test_a, __c_test_b) <= (abs_error)))) { const c_test_value_t __c_test_values[2] = {C_TEST_VALUE(__c_test_a), C_TEST_VALUE(__c_test_b)}; c_test_compare_failure(__runner, 0, "EXPECT_NEAR("#a", "#b", "#abs_error")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); } else C_TEST_PASS(); }
+#define EXPECT_ULP_EQ(a, b, max_ulps, ...) { C_TEST_AUTO __c_test_a = (a); C_TEST_AUTO __c_test_b = (b); if (C_TEST_UNLIKELY(C_TEST_ULP_DISTANCE(__c_test_a, __c_test_b) > (uint64_t)(max_ulps))) { const c_test_value_t __c_test_values[2] = {C_TEST_VALUE(__c_test_a), C_TEST_VALUE(__c_test_b)}; c_test_compare_failure(__runner, 0, "EXPECT_ULP_EQ("#a", "#b", "#max_ulps")", __FILE__, __LINE__, #a, #b, __c_test_values, __VA_ARGS__); } else C_TEST_PASS(); }
+#define EXPECT_MEMEQ(a, b, size, ...) { const void *__c_test_a = (a); const void *__c_test_b = (b); const size_t __c_test_size = (size); if (C_TEST_UNLIKELY(memcmp(__c_test_a, __c_test_b, __c_test_size) != 0)) { c_test_memeq_failure(__runner, 0, "EXPECT_MEMEQ("#a", "#b", "#size")", __FILE__, __LINE__, __c_test_a, __c_test_b, __c_test_size, __VA_ARGS__); } else C_TEST_PASS(); }
+
+#define ASSERT_ALLOCATIONS_LE(n, statement, ...) { \
+	const uint64_t __c_test_allocation_count = c_test_allocation_count(); \
+	statement; \
+	if (C_TEST_UNLIKELY(!c_test_allocation_tracking_enabled())) { c_test_allocation_tracking_missing(__runner, 1, "ASSERT_ALLOCATIONS_LE("#n", "#statement")", __FILE__, __LINE__); return; } \
+	else if (C_TEST_UNLIKELY(c_test_allocation_count() - __c_test_allocation_count > (uint64_t)(n))) { c_test_failure(__runner, "ASSERT_ALLOCATIONS_LE("#n", "#statement")", __FILE__, __LINE__, __VA_ARGS__); return; } else C_TEST_PASS(); }
+#define EXPECT_ALLOCATIONS_LE(n, statement, ...) { \
+	const uint64_t __c_test_allocation_count = c_test_allocation_count(); \
+	statement; \
+	if (C_TEST_UNLIKELY(!c_test_allocation_tracking_enabled())) { c_test_allocation_tracking_missing(__runner, 0, "EXPECT_ALLOCATIONS_LE("#n", "#statement")", __FILE__, __LINE__); } \
+	else if (C_TEST_UNLIKELY(c_test_allocation_count() - __c_test_allocation_count > (uint64_t)(n))) { c_test_error(__runner, "EXPECT_ALLOCATIONS_LE("#n", "#statement")", __FILE__, __LINE__, __VA_ARGS__); } else C_TEST_PASS(); }
+#define ASSERT_NO_ALLOCATIONS(statement, ...) ASSERT_ALLOCATIONS_LE(0, statement, __VA_ARGS__)
+#define EXPECT_NO_ALLOCATIONS(statement, ...) EXPECT_ALLOCATIONS_LE(0, statement, __VA_ARGS__)
 
 
 // === Test Definition Macros === //
@@ -157,7 +618,42 @@ int c_test_run(c_test_runner_t* runner);
 #define TEST(namespace, test_name) \
 	C_TEST_TEST0(namespace, test_name, C_TEST_STR(namespace), C_TEST_STR(test_name), __FILE__, __LINE__)
 
+// Runs the body once per element of the array params, each reported as "namespace.test_name/<index>" and selectable
+// by --filter. The body reads its element through the pointer param_, e.g.
+//   static const int kPrimes[] = {2, 3, 5, 7};
+//   TEST_P(Primes, odd, int, kPrimes) { EXPECT_TRUE(*param_ == 2 || *param_ % 2 == 1, "%d", *param_); }
+#define TEST_P(namespace, test_name, type, params) \
+	C_TEST_TEST_P0(namespace, test_name, type, params, C_TEST_STR(namespace), C_TEST_STR(test_name), __FILE__, __LINE__)
+
+// The body checks one input of size_ bytes at data_, e.g. that parsing it does not crash and round trips. It runs as a
+// test on an empty input, and --fuzz mutates inputs guided by the coverage of code compiled with
+// -fsanitize-coverage=trace-pc-guard (Clang) or -fsanitize-coverage=trace-pc (GCC).
+#define FUZZ_TEST(namespace, test_name) \
+	C_TEST_FUZZ_TEST0(namespace, test_name, C_TEST_STR(namespace), C_TEST_STR(test_name), __FILE__, __LINE__)
+
+// The body runs its measured code iterations_ times, e.g. for (uint64_t i = 0; i < iterations_; i++) { ... }
+#define BENCHMARK(namespace, benchmark_name) \
+	C_TEST_BENCHMARK0(namespace, benchmark_name, C_TEST_STR(namespace), C_TEST_STR(benchmark_name), __FILE__, __LINE__)
+
+// Times the statement or block that follows in batches, and reports an error when its median time is slower than the
+// baseline recorded by --record-baseline plus three of the baseline's median absolute deviations, by more than
+// tolerance (0.1 for 10%). The block must not break out of the loop, e.g.
+//   EXPECT_FASTER_THAN_BASELINE(hash_64_bytes, 0.1) { DO_NOT_OPTIMIZE(hash(buffer, 64)); }
+#define EXPECT_FASTER_THAN_BASELINE(name, tolerance) \
+	for (c_test_perf_t __c_test_perf = c_test_perf_begin(__runner, #name, "EXPECT_FASTER_THAN_BASELINE("#name", "#tolerance")", (tolerance), __FILE__, __LINE__); \
+		 c_test_perf_next(&__c_test_perf); )
+
+// === Benchmark Helpers === //
+
+// Forces value to be computed, without the cost of storing it anywhere.
+#define DO_NOT_OPTIMIZE(value) __asm__ __volatile__("" : : "r,m"(value) : "memory")
+// Forces all pending writes to memory to be considered visible.
+#define CLOBBER_MEMORY() __asm__ __volatile__("" : : : "memory")
+
 // === Runner Macros === //
 
 #define RUN_ALL_TESTS() \
-	c_test_run(c_test_create_default_runner())
+	(C_TEST_REGISTER_DEFINITION_TABLE(), c_test_run(c_test_create_default_runner()))
+
+#define RUN_ALL_TESTS_WITH_ARGS(argc, argv) \
+	(C_TEST_REGISTER_DEFINITION_TABLE(), c_test_main(c_test_create_default_runner(), (argc), (const char **)(argv)))
@@ -5,62 +5,162 @@ one_variable = {
     "false": "{value}",
 }
 
-two_variable = {
+# Operands are evaluated once into __c_test_a and __c_test_b of their own type (C_TEST_AUTO), which the failure message
+# prints.
+typed_two_variable = {
     "eq": "{a} != {b}",
     "ne": "{a} == {b}",
     "lt": "{a} >= {b}",
     "le": "{a} > {b}",
     "gt": "{a} <= {b}",
     "ge": "{a} < {b}",
+}
 
+string_two_variable = {
     "streq": "strcmp({a}, {b}) != 0",
     "strne": "strcmp({a}, {b}) == 0",
     "strcaseq": "strcasecmp({a}, {b}) != 0",
     "strcasne": "strcasecmp({a}, {b}) == 0",
 }
 
+# Maps each type to the function capturing its values for failure messages. Anything else is printed as a pointer. C
+# dispatches with _Generic, C++ with an overload per type.
+value_functions = [
+    ("_Bool", "c_test_unsigned_value"),
+    ("char", "c_test_char_value"),
+    ("signed char", "c_test_signed_value"),
+    ("unsigned char", "c_test_unsigned_value"),
+    ("short", "c_test_signed_value"),
+    ("unsigned short", "c_test_unsigned_value"),
+    ("int", "c_test_signed_value"),
+    ("unsigned int", "c_test_unsigned_value"),
+    ("long", "c_test_signed_value"),
+    ("unsigned long", "c_test_unsigned_value"),
+    ("long long", "c_test_signed_value"),
+    ("unsigned long long", "c_test_unsigned_value"),
+    ("float", "c_test_float_value"),
+    ("double", "c_test_double_value"),
+    ("long double", "c_test_long_double_value"),
+    ("default", "c_test_pointer_value"),
+]
+
 def enclose_variable(variable):
     '''Used for making macro variables safe.'''
     return '({})'.format(variable)
 
-for macro_prefix, error_type in [('ASSERT', 'failure'), ('EXPECT', 'error')]:
+def compare_call(value):
+    '''Captures both operands with value, a format taking the variable name, and reports them.'''
+    return ('const c_test_value_t __c_test_values[2] = {{{a_value}, {b_value}}}; '
+            'c_test_compare_failure(__runner, {{is_failure}}, {{expression}}, __FILE__, __LINE__, '
+            '#a, #b, __c_test_values, __VA_ARGS__);').format(
+        a_value=value.format('__c_test_a'),
+        b_value=value.format('__c_test_b'),
+    )
+
+def return_stmt(is_failure):
+    return ' return;' if is_failure else ''
+
+def macro_body(macro_cmp, report_fn, expression):
+    '''The failure path is an out of line cold call, so passing assertions cost only their comparison.'''
+    return 'if (C_TEST_UNLIKELY({macro_cmp})) {{ {report_fn}(__runner, {expression}, __FILE__, __LINE__, __VA_ARGS__);{return_stmt} }} else C_TEST_PASS()'.format(
+        macro_cmp=macro_cmp,
+        report_fn=report_fn,
+        expression=expression,
+        return_stmt=return_stmt(report_fn == 'c_test_failure'),
+    )
+
+def captured_body(declarations, macro_cmp, is_failure, expression, report_call):
+    '''Evaluates the operands once, then reports them by value on failure.'''
+    return '{{ {declarations} if (C_TEST_UNLIKELY({macro_cmp})) {{ {report_call}{return_stmt} }} else C_TEST_PASS(); }}'.format(
+        declarations=declarations,
+        macro_cmp=macro_cmp,
+        report_call=report_call.replace('{is_failure}', str(int(is_failure))).replace('{expression}', expression),
+        return_stmt=return_stmt(is_failure),
+    )
+
+print('#ifdef __cplusplus')
+print('extern "C++" {')
+for type_name, function in value_functions:
+    if type_name == 'default':
+        print('template <typename T> inline c_test_value_t c_test_value(T *value) {{ return {}((const void*)value); }}'.format(
+            function))
+        print('inline c_test_value_t c_test_value(decltype(nullptr)) {{ return {}(NULL); }}'.format(function))
+    else:
+        print('inline c_test_value_t c_test_value({} value) {{ return {}(value); }}'.format(
+            'bool' if type_name == '_Bool' else type_name, function))
+print('}')
+print('#define C_TEST_VALUE(value) c_test_value(value)')
+print('#else')
+print('#define C_TEST_VALUE(value) _Generic((value), {functions})(value)'.format(
+    functions=', '.join('{}: {}'.format(type_name, function) for type_name, function in value_functions)))
+print('#endif')
+print('')
+
+for macro_prefix, report_fn in [('ASSERT', 'c_test_failure'), ('EXPECT', 'c_test_error')]:
+    is_failure = report_fn == 'c_test_failure'
+
     for name, template in one_variable.items():
         variable_name = 'a'
         macro_name = '{macro_prefix}_{name}'.format(macro_prefix=macro_prefix, name=name.upper())
         macro_cmp = template.format(value=enclose_variable(variable_name))
-        macro_body = 'if ({macro_cmp}) {{ {return_fn} __runner->{error_type}(__runner,  "{macro_name}("#{variable_name}")", __FILE__, __LINE__, __VA_ARGS__); }}'.format(
-            return_fn='return' if error_type == 'failure' else '',
-            variable_name=variable_name,
-            macro_name=macro_name,
-            macro_cmp=macro_cmp,
-            error_type=error_type,
-        )
+        expression = '"{macro_name}("#{variable_name}")"'.format(macro_name=macro_name, variable_name=variable_name)
         macro = '#define {macro_name}({variable_name}, ...) {macro_body}'.format(
             macro_name=macro_name,
             variable_name=variable_name,
-            macro_body=macro_body,
+            macro_body=macro_body(macro_cmp, report_fn, expression),
         )
-        print macro
+        print(macro)
 
-    print ''
+    print('')
 
-    for name, template in two_variable.items():
-        variable_names = ['a', 'b']
+    for name, template in list(typed_two_variable.items()) + list(string_two_variable.items()):
         macro_name = '{macro_prefix}_{name}'.format(macro_prefix=macro_prefix, name=name.upper())
-        macro_cmp = template.format(a=enclose_variable(variable_names[0]), b=enclose_variable(variable_names[1]))
-        macro_body = 'if ({macro_cmp}) {{ {return_fn} __runner->{error_type}(__runner, "{macro_name}("#{a}", "#{b}")", __FILE__, __LINE__, __VA_ARGS__); }}'.format(
-            return_fn='return' if error_type == 'failure' else '',
-            a=variable_names[0],
-            b=variable_names[1],
+        if name in typed_two_variable:
+            declarations = 'C_TEST_AUTO __c_test_a = (a); C_TEST_AUTO __c_test_b = (b);'
+            value = 'C_TEST_VALUE({})'
+        else:
+            declarations = 'const char *__c_test_a = (a); const char *__c_test_b = (b);'
+            value = 'c_test_string_value({})'
+        report_call = compare_call(value)
+        macro = '#define {macro_name}(a, b, ...) {macro_body}'.format(
             macro_name=macro_name,
-            macro_cmp=macro_cmp,
-            error_type=error_type,
+            macro_body=captured_body(declarations, template.format(a='__c_test_a', b='__c_test_b'), is_failure,
+                                     '"{macro_name}("#a", "#b")"'.format(macro_name=macro_name), report_call),
         )
-        macro = '#define {macro_name}({a}, {b}, ...) {macro_body}'.format(
-            macro_name=macro_name,
-            a=variable_names[0],
-            b=variable_names[1],
-            macro_body=macro_body,
-        )
-        print macro
-    print ''
+        print(macro)
+
+    print('')
+
+    value_call = compare_call('C_TEST_VALUE({})')
+
+    # Fails on NaN, which is not within any error of anything.
+    macro_name = '{}_NEAR'.format(macro_prefix)
+    print('#define {macro_name}(a, b, abs_error, ...) {macro_body}'.format(
+        macro_name=macro_name,
+        macro_body=captured_body(
+            'const double __c_test_a = (a); const double __c_test_b = (b);',
+            '!(c_test_abs_difference(__c_test_a, __c_test_b) <= (abs_error))',
+            is_failure, '"{}("#a", "#b", "#abs_error")"'.format(macro_name), value_call),
+    ))
+
+    # Compares floats in float ULPs and anything else in double ULPs.
+    macro_name = '{}_ULP_EQ'.format(macro_prefix)
+    print('#define {macro_name}(a, b, max_ulps, ...) {macro_body}'.format(
+        macro_name=macro_name,
+        macro_body=captured_body(
+            'C_TEST_AUTO __c_test_a = (a); C_TEST_AUTO __c_test_b = (b);',
+            'C_TEST_ULP_DISTANCE(__c_test_a, __c_test_b) > (uint64_t)(max_ulps)',
+            is_failure, '"{}("#a", "#b", "#max_ulps")"'.format(macro_name), value_call),
+    ))
+
+    macro_name = '{}_MEMEQ'.format(macro_prefix)
+    print('#define {macro_name}(a, b, size, ...) {macro_body}'.format(
+        macro_name=macro_name,
+        macro_body=captured_body(
+            'const void *__c_test_a = (a); const void *__c_test_b = (b); const size_t __c_test_size = (size);',
+            'memcmp(__c_test_a, __c_test_b, __c_test_size) != 0',
+            is_failure, '"{}("#a", "#b", "#size")"'.format(macro_name),
+            'c_test_memeq_failure(__runner, {is_failure}, {expression}, __FILE__, __LINE__, __c_test_a, __c_test_b, '
+            '__c_test_size, __VA_ARGS__);'),
+    ))
+    print('')
@@ -0,0 +1,36 @@
+#include "c_test.h"
+
+#include <signal.h>
+#include <unistd.h>
+
+// Tests run by c_test_tests through the command line options under test. Crash and Hang only pass under --isolate.
+
+TEST(Pass, one) {
+	ASSERT_TRUE(1, "true is true");
+}
+
+TEST(Pass, two) {
+	ASSERT_EQ(2, 1 + 1, "one and one make two");
+}
+
+TEST(Pass, three) {
+	EXPECT_NE(3, 4, "three is not four");
+}
+
+TEST(Fail, assertion) {
+	EXPECT_EQ(1, 2, "one is not two");
+}
+
+TEST(Crash, segfault) {
+	raise(SIGSEGV);
+}
+
+TEST(Hang, forever) {
+	for (;;) {
+		pause();
+	}
+}
+
+int main(int argc, const char **argv) {
+	return RUN_ALL_TESTS_WITH_ARGS(argc, argv);
+}
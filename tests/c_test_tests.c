@@ -0,0 +1,176 @@
+#include "c_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+
+// Runs c_test_samples with the options under test and checks what it reports. C_TEST_SAMPLES_PATH and
+// C_TEST_TESTS_DIR, where the tests write their files, are defined by the build.
+
+#define OUTPUT_SIZE 65536
+
+const char *kSamplesPath = C_TEST_SAMPLES_PATH;
+
+// Runs the samples with arguments, returns their exit status and leaves what they printed in output.
+int run_samples(const char *arguments, char *output) {
+	char command[4096];
+	snprintf(command, sizeof(command), "'%s' %s 2>&1", kSamplesPath, arguments);
+	output[0] = '\0';
+	FILE *pipe = popen(command, "r");
+	if (NULL == pipe) {
+		return -1;
+	}
+	const size_t size = fread(output, 1, OUTPUT_SIZE - 1, pipe);
+	output[size] = '\0';
+	const int status = pclose(pipe);
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// Counts the lines of text containing both first and second.
+uint32_t count_lines(const char *text, const char *first, const char *second) {
+	uint32_t count = 0;
+	while ('\0' != *text) {
+		const char *line_end = strchr(text, '\n');
+		const size_t line_size = NULL == line_end ? strlen(text) : (size_t)(line_end - text);
+		char line[1024];
+		snprintf(line, sizeof(line), "%.*s", (int)line_size, text);
+		if (NULL != strstr(line, first) && NULL != strstr(line, second)) {
+			count++;
+		}
+		text += line_size + (NULL != line_end);
+	}
+	return count;
+}
+
+// Reads path into buffer, returns 0 if it cannot be read.
+int read_file(const char *path, char *buffer) {
+	FILE *file = fopen(path, "rb");
+	if (NULL == file) {
+		return 0;
+	}
+	const size_t size = fread(buffer, 1, OUTPUT_SIZE - 1, file);
+	buffer[size] = '\0';
+	fclose(file);
+	return 1;
+}
+
+TEST(Filter, RunsPositiveMinusNegativePatterns) {
+	static char output[OUTPUT_SIZE];
+	ASSERT_EQ(run_samples("--list '--filter=Pass.*-Pass.two'", output), 0, "%s", output);
+	EXPECT_EQ(count_lines(output, "Pass.one", ""), 1u, "%s", output);
+	EXPECT_EQ(count_lines(output, "Pass.three", ""), 1u, "%s", output);
+	EXPECT_EQ(count_lines(output, ".", ""), 2u, "%s", output);
+}
+
+TEST(Filter, FailingTestFailsTheRun) {
+	static char output[OUTPUT_SIZE];
+	EXPECT_NE(run_samples("'--filter=Pass.one:Fail.*'", output), 0, "%s", output);
+	EXPECT_EQ(count_lines(output, "error", "one is not two"), 1u, "%s", output);
+	EXPECT_EQ(count_lines(output, "OK ]", "Pass.one"), 1u, "%s", output);
+}
+
+TEST(Shard, ShardsPartitionTheTests) {
+	static char first[OUTPUT_SIZE];
+	static char second[OUTPUT_SIZE];
+	ASSERT_EQ(run_samples("--list '--filter=Pass.*' --total-shards=2 --shard-index=0", first), 0, "%s", first);
+	ASSERT_EQ(run_samples("--list '--filter=Pass.*' --total-shards=2 --shard-index=1", second), 0, "%s", second);
+	const char *names[] = {"Pass.one\n", "Pass.two\n", "Pass.three\n"};
+	for (int i = 0; i < 3; i++) {
+		EXPECT_EQ((NULL != strstr(first, names[i])) + (NULL != strstr(second, names[i])), 1,
+				  "%s is in one shard:\n%s--\n%s", names[i], first, second);
+	}
+}
+
+TEST(Repeat, SummarizesEveryRepetition) {
+	static char output[OUTPUT_SIZE];
+	ASSERT_EQ(run_samples("--filter=Pass.one --repeat=3", output), 0, "%s", output);
+	EXPECT_EQ(count_lines(output, "OK ]", "Pass.one"), 3u, "%s", output);
+	EXPECT_EQ(count_lines(output, "[ REPEATED ] Pass.one", "passed 3/3"), 1u, "%s", output);
+}
+
+TEST(Shuffle, SeedReproducesTheOrder) {
+	static char first[OUTPUT_SIZE];
+	static char second[OUTPUT_SIZE];
+	ASSERT_EQ(run_samples("--list '--filter=Pass.*' --shuffle=7", first), 0, "%s", first);
+	ASSERT_EQ(run_samples("--list '--filter=Pass.*' --shuffle=7", second), 0, "%s", second);
+	EXPECT_STREQ(first, second, "order with the same seed");
+	EXPECT_EQ(count_lines(first, "Pass.", ""), 3u, "%s", first);
+
+	static char output[OUTPUT_SIZE];
+	ASSERT_EQ(run_samples("'--filter=Pass.*' --shuffle=7", output), 0, "%s", output);
+	EXPECT_EQ(count_lines(output, "Shuffled with --shuffle=7", ""), 1u, "%s", output);
+}
+
+TEST(Isolate, CrashFailsOnlyTheCrashingTest) {
+	static char output[OUTPUT_SIZE];
+	EXPECT_NE(run_samples("--isolate '--filter=Pass.one:Crash.*:Pass.two'", output), 0, "%s", output);
+	EXPECT_EQ(count_lines(output, "error", "Test crashed with signal"), 1u, "%s", output);
+	EXPECT_EQ(count_lines(output, "FAILED  ]", "Crash.segfault"), 2u, "%s", output);
+	EXPECT_EQ(count_lines(output, "OK ]", "Pass."), 2u, "%s", output);
+}
+
+TEST(Isolate, TimeoutKillsTheHangingTest) {
+	static char output[OUTPUT_SIZE];
+	EXPECT_NE(run_samples("--isolate --timeout-ms=100 '--filter=Hang.*:Pass.one'", output), 0, "%s", output);
+	EXPECT_EQ(count_lines(output, "error", "Test timed out after 100 ms"), 1u, "%s", output);
+	EXPECT_EQ(count_lines(output, "OK ]", "Pass.one"), 1u, "%s", output);
+}
+
+TEST(Output, JsonLinesHaveALinePerTest) {
+	const char *path = C_TEST_TESTS_DIR "/c_test_tests.jsonl";
+	remove(path);
+	static char arguments[4096];
+	snprintf(arguments, sizeof(arguments), "'--filter=Pass.one:Fail.*' '--output=jsonl:%s'", path);
+	static char output[OUTPUT_SIZE];
+	EXPECT_NE(run_samples(arguments, output), 0, "%s", output);
+
+	static char report[OUTPUT_SIZE];
+	ASSERT_TRUE(read_file(path, report), "%s was not written", path);
+	EXPECT_EQ(count_lines(report, "\"type\":\"begin\"", "\"test_count\":2"), 1u, "%s", report);
+	EXPECT_EQ(count_lines(report, "\"test_name\":\"one\"", "\"success\":true"), 1u, "%s", report);
+	EXPECT_EQ(count_lines(report, "\"test_name\":\"assertion\"", "\"message\":\"one is not two\""), 1u, "%s", report);
+	EXPECT_EQ(count_lines(report, "\"type\":\"end\"", "\"failed_count\":1"), 1u, "%s", report);
+}
+
+TEST(Output, JUnitReportsFailures) {
+	const char *path = C_TEST_TESTS_DIR "/c_test_tests.xml";
+	remove(path);
+	static char arguments[4096];
+	snprintf(arguments, sizeof(arguments), "'--filter=Pass.one:Fail.*' '--output=xml:%s'", path);
+	static char output[OUTPUT_SIZE];
+	EXPECT_NE(run_samples(arguments, output), 0, "%s", output);
+
+	static char report[OUTPUT_SIZE];
+	ASSERT_TRUE(read_file(path, report), "%s was not written", path);
+	EXPECT_EQ(count_lines(report, "<testsuites", "tests=\"2\""), 1u, "%s", report);
+	EXPECT_EQ(count_lines(report, "<testcase classname=\"Pass\"", "name=\"one\""), 1u, "%s", report);
+	EXPECT_EQ(count_lines(report, "<failure", "one is not two"), 1u, "%s", report);
+	EXPECT_EQ(count_lines(report, "</testsuites>", ""), 1u, "%s", report);
+}
+
+TEST(ResultsCache, OnlyFailedRunsTheTestsThatFailed) {
+	const char *path = C_TEST_TESTS_DIR "/c_test_tests.cache";
+	remove(path);
+	static char arguments[4096];
+	static char output[OUTPUT_SIZE];
+	snprintf(arguments, sizeof(arguments), "'--filter=Pass.*:Fail.*' '--results-cache=%s'", path);
+	EXPECT_NE(run_samples(arguments, output), 0, "%s", output);
+
+	snprintf(arguments, sizeof(arguments), "--list '--filter=Pass.*:Fail.*' '--results-cache=%s' --only-failed", path);
+	ASSERT_EQ(run_samples(arguments, output), 0, "%s", output);
+	EXPECT_STREQ(output, "Fail.assertion\n", "tests that failed last time");
+
+	snprintf(arguments, sizeof(arguments), "--list '--filter=Pass.*:Fail.*' '--results-cache=%s' --failed-first", path);
+	ASSERT_EQ(run_samples(arguments, output), 0, "%s", output);
+	EXPECT_EQ(strncmp(output, "Fail.assertion\n", strlen("Fail.assertion\n")), 0, "%s", output);
+	const char *names[] = {"Pass.one", "Pass.two", "Pass.three"};
+	for (int i = 0; i < 3; i++) {
+		EXPECT_EQ(count_lines(output, names[i], ""), 1u, "%s is listed once:\n%s", names[i], output);
+	}
+	EXPECT_EQ(count_lines(output, ".", ""), 4u, "%s", output);
+}
+
+int main(int argc, const char **argv) {
+	return RUN_ALL_TESTS_WITH_ARGS(argc, argv);
+}